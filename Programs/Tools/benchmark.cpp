@@ -0,0 +1,411 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "../Version3/pathfinder.h"
+#include "syntheticgrid.h"
+
+/**
+ * Settings given as --name=value flags after the positional arguments.
+ */
+struct BenchmarkOptions
+{
+    int repetitions = 5;                             // The number of times each stage is timed
+    std::vector<int> syntheticSizes = {64, 128, 256, 512}; // The rows and columns of each generated grid
+    int syntheticNodes = 16;                         // The number of nodes placed on each generated grid
+    std::string binaryPrefix;                        // The prefix of the built Version1-3 executables to run end to end
+    std::string csvPath;                             // The CSV report to write, if any
+    std::string jsonPath;                            // The JSON report to write, if any
+};
+
+/**
+ * A grid and node list to benchmark, searched between its first two nodes.
+ */
+struct BenchmarkCase
+{
+    std::string name;
+    std::string gridPath;
+    std::string nodesPath;
+};
+
+/**
+ * The timings of one stage of one case, in milliseconds.
+ */
+struct StageResult
+{
+    std::string caseName;
+    std::string stage;
+    std::vector<double> samples;
+};
+
+/**
+ * Times a function a number of times.
+ *
+ * @param repetitions The number of times to run the function
+ * @param run The function to time
+ * @return std::vector<double> The time of each run in milliseconds
+ */
+template <typename Function>
+std::vector<double> timeRepetitions(int repetitions, Function &&run)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < repetitions; i++)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+    }
+    return samples;
+}
+
+/**
+ * Get the nearest-rank percentile of sorted samples.
+ *
+ * @param sorted The samples in ascending order
+ * @param p The percentile between 0 and 100
+ * @return double The sample at the percentile
+ */
+double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+/**
+ * Finds every node list of every grid_* folder of a data set.
+ *
+ * @param dataSetPath The folder holding the grid_* folders
+ * @return std::vector<BenchmarkCase> One case per node list, in name order
+ */
+std::vector<BenchmarkCase> findDataSetCases(const std::string &dataSetPath)
+{
+    std::vector<BenchmarkCase> cases;
+    for (const auto &gridFolder : std::filesystem::directory_iterator(dataSetPath))
+    {
+        std::string gridName = gridFolder.path().filename().string();
+        if (!gridFolder.is_directory() || gridName.rfind("grid_", 0) != 0 || !std::filesystem::exists(gridFolder.path() / "grid.txt"))
+        {
+            continue;
+        }
+
+        for (const auto &file : std::filesystem::directory_iterator(gridFolder.path()))
+        {
+            std::string fileName = file.path().filename().string();
+            if (fileName.rfind("nodeList", 0) == 0)
+            {
+                cases.push_back({gridName + "/" + file.path().stem().string(), (gridFolder.path() / "grid.txt").string(), file.path().string()});
+            }
+        }
+    }
+
+    std::sort(cases.begin(), cases.end(), [](const BenchmarkCase &a, const BenchmarkCase &b)
+              { return a.name < b.name; });
+    return cases;
+}
+
+/**
+ * Writes a square grid of uniformly random costs and a list of nodes at distinct random cells, in the text formats read
+ * by the programs.
+ *
+ * @param folder The folder to write the grid and node files to
+ * @param size The number of rows and columns
+ * @param numNodes The number of nodes
+ * @return BenchmarkCase The case of the generated files
+ */
+BenchmarkCase writeSyntheticCase(const std::string &folder, int size, int numNodes)
+{
+    std::string name = "synthetic_" + std::to_string(size) + "x" + std::to_string(size);
+    BenchmarkCase benchmarkCase = {name, folder + "/" + name + "_grid.txt", folder + "/" + name + "_nodes.txt"};
+
+    SyntheticGridOptions gridOptions;
+    gridOptions.rows = size;
+    gridOptions.cols = size;
+    gridOptions.seed = size;
+    writeSyntheticGrid(gridOptions, benchmarkCase.gridPath, false);
+    writeSyntheticNodes(placeSyntheticNodes(size, size, numNodes, size), benchmarkCase.nodesPath);
+
+    return benchmarkCase;
+}
+
+/**
+ * Runs an executable to completion with its output discarded.
+ *
+ * @param executable The path to the executable
+ * @param args The arguments to pass to it
+ * @return bool True if it exited with status 0, false otherwise
+ */
+bool runExecutable(const std::string &executable, const std::vector<std::string> &args)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+
+        std::vector<char *> argv = {const_cast<char *>(executable.c_str())};
+        for (const std::string &arg : args)
+        {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(executable.c_str(), argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * Times every stage of a case: parsing the grid, connecting the closest nodes, enumerating the valid paths, searching
+ * the subpath between the first two nodes, and the full forked search of Version3. If a binary prefix is given, the
+ * built Version1-3 executables are also timed end to end.
+ *
+ * @param benchmarkCase The grid and node list to time
+ * @param options The number of repetitions and the executables to time
+ * @param scrapFolderPath The folder for the scrap and output files
+ * @param results The results to append the timings to
+ */
+void runBenchmarkCase(const BenchmarkCase &benchmarkCase, const BenchmarkOptions &options, const std::string &scrapFolderPath, std::vector<StageResult> &results)
+{
+    CostGrid grid;
+    results.push_back({benchmarkCase.name, "parse_grid", timeRepetitions(options.repetitions, [&]
+                                                                         { grid = createCostGrid(benchmarkCase.gridPath); })});
+
+    Graph graph(benchmarkCase.nodesPath);
+    if (graph.getNumNodes() < 2 || !overlayGraph(graph, grid))
+    {
+        std::cerr << "Skipping " << benchmarkCase.name << ": it needs at least 2 nodes within the grid." << std::endl;
+        return;
+    }
+    results.push_back({benchmarkCase.name, "closest_nodes", timeRepetitions(options.repetitions, [&]
+                                                                            { graph.findClosestNodes(); })});
+
+    std::vector<std::vector<int>> validPaths;
+    results.push_back({benchmarkCase.name, "enumerate_paths", timeRepetitions(options.repetitions, [&]
+                                                                              { validPaths = graph.findValidPaths(0, 1); })});
+
+    // Search the subpath over the same padded rectangle the program searches it within
+    std::pair<int, int> startPos = graph.getNodePosition(0);
+    std::pair<int, int> endPos = graph.getNodePosition(1);
+    int startRow = std::max(std::min(startPos.first, endPos.first) - corridorPadding, 0);
+    int endRow = std::min(std::max(startPos.first, endPos.first) + corridorPadding, grid.getNumRows() - 1);
+    int startCol = std::max(std::min(startPos.second, endPos.second) - corridorPadding, 0);
+    int endCol = std::min(std::max(startPos.second, endPos.second) + corridorPadding, grid.getNumCols() - 1);
+    results.push_back({benchmarkCase.name, "astar_subpath", timeRepetitions(options.repetitions, [&]
+                                                                            {
+                                                                                std::vector<std::pair<int, int>> cells;
+                                                                                aStar(grid, cells, startPos, endPos, startRow, endRow, startCol, endCol, scrapFolderPath, 0, 0); })});
+
+    // The forked processes exit through the same stream buffers, so flush them first
+    std::cout << std::flush;
+    results.push_back({benchmarkCase.name, "find_cheapest_path", timeRepetitions(options.repetitions, [&]
+                                                                                 { findCheapestPath(graph, grid, validPaths, 0, scrapFolderPath, 0); })});
+
+    if (!options.binaryPrefix.empty())
+    {
+        for (int version = 1; version <= 3; version++)
+        {
+            std::string executable = options.binaryPrefix + std::to_string(version);
+            std::vector<std::string> args = {benchmarkCase.gridPath, benchmarkCase.nodesPath, "0", "1",
+                                             scrapFolderPath + "/v" + std::to_string(version), scrapFolderPath + "/output_v" + std::to_string(version) + ".txt"};
+            bool succeeded = true;
+            std::vector<double> samples = timeRepetitions(options.repetitions, [&]
+                                                          { succeeded = runExecutable(executable, args) && succeeded; });
+            if (!succeeded)
+            {
+                std::cerr << "Skipping Version" << version << " on " << benchmarkCase.name << ": " << executable << " failed." << std::endl;
+                continue;
+            }
+            results.push_back({benchmarkCase.name, "end_to_end_v" + std::to_string(version), samples});
+        }
+    }
+}
+
+/**
+ * Writes the summary of every stage as CSV.
+ *
+ * @param results The timings of every stage
+ * @param out The stream to write to
+ */
+void writeCsv(const std::vector<StageResult> &results, std::ostream &out)
+{
+    out << "case,stage,repetitions,min_ms,mean_ms,p50_ms,p90_ms,p99_ms,max_ms" << std::endl;
+    for (StageResult result : results)
+    {
+        std::sort(result.samples.begin(), result.samples.end());
+        double mean = 0;
+        for (double sample : result.samples)
+        {
+            mean += sample / result.samples.size();
+        }
+        out << result.caseName << "," << result.stage << "," << result.samples.size() << "," << result.samples.front() << "," << mean << ","
+            << percentile(result.samples, 50) << "," << percentile(result.samples, 90) << "," << percentile(result.samples, 99) << ","
+            << result.samples.back() << std::endl;
+    }
+}
+
+/**
+ * Writes every sample of every stage as JSON, with the same summary as the CSV.
+ *
+ * @param results The timings of every stage
+ * @param out The stream to write to
+ */
+void writeJson(const std::vector<StageResult> &results, std::ostream &out)
+{
+    out << "[" << std::endl;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        std::vector<double> sorted = results[i].samples;
+        std::sort(sorted.begin(), sorted.end());
+        out << "  {\"case\": \"" << results[i].caseName << "\", \"stage\": \"" << results[i].stage << "\", \"samples_ms\": [";
+        for (size_t j = 0; j < results[i].samples.size(); j++)
+        {
+            out << (j == 0 ? "" : ", ") << results[i].samples[j];
+        }
+        out << "], \"min_ms\": " << sorted.front() << ", \"p50_ms\": " << percentile(sorted, 50) << ", \"p90_ms\": " << percentile(sorted, 90)
+            << ", \"p99_ms\": " << percentile(sorted, 99) << ", \"max_ms\": " << sorted.back() << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "]" << std::endl;
+}
+
+/**
+ * Parses a comma separated list of sizes.
+ *
+ * @param value The list
+ * @return std::vector<int> The sizes
+ */
+std::vector<int> parseSizes(const std::string &value)
+{
+    std::vector<int> sizes;
+    std::istringstream iss(value);
+    std::string size;
+    while (std::getline(iss, size, ','))
+    {
+        sizes.push_back(std::stoi(size));
+        if (sizes.back() < 2)
+        {
+            throw std::invalid_argument("Synthetic grids need at least 2 rows and columns.");
+        }
+    }
+    return sizes;
+}
+
+/**
+ * Benchmarks the stages of the Version3 program over every node list of a data set and over generated grids of
+ * increasing size, prints the percentiles of each stage and optionally writes them as CSV and JSON.
+ */
+int main(int argc, char **argv)
+{
+    const std::string usage = "Usage: " + std::string(argv[0]) + " <dataSetFolder> <scrapFolderPath> [--repetitions=N] [--sizes=N,N,...]"
+                              " [--synthetic-nodes=N] [--binaries=<executable prefix>] [--csv=<path>] [--json=<path>]";
+
+    std::vector<std::string> args;
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        try
+        {
+            if (arg.rfind("--", 0) != 0)
+            {
+                args.push_back(arg);
+            }
+            else if (name == "--repetitions" && std::stoi(value) > 0)
+            {
+                options.repetitions = std::stoi(value);
+            }
+            else if (name == "--sizes")
+            {
+                options.syntheticSizes = value.empty() ? std::vector<int>() : parseSizes(value);
+            }
+            else if (name == "--synthetic-nodes" && std::stoi(value) >= 2)
+            {
+                options.syntheticNodes = std::stoi(value);
+            }
+            else if (name == "--binaries" && !value.empty())
+            {
+                options.binaryPrefix = value;
+            }
+            else if (name == "--csv" && !value.empty())
+            {
+                options.csvPath = value;
+            }
+            else if (name == "--json" && !value.empty())
+            {
+                options.jsonPath = value;
+            }
+            else
+            {
+                throw std::invalid_argument(arg);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "Invalid option " << arg << ". " << usage << std::endl;
+            return 53;
+        }
+    }
+    if (args.size() != 2)
+    {
+        std::cout << usage << std::endl;
+        return 51;
+    }
+
+    std::string scrapFolderPath = args[1];
+    std::filesystem::create_directories(scrapFolderPath);
+
+    std::vector<BenchmarkCase> cases = findDataSetCases(args[0]);
+    for (int size : options.syntheticSizes)
+    {
+        if (size * size > options.syntheticNodes)
+        {
+            cases.push_back(writeSyntheticCase(scrapFolderPath, size, options.syntheticNodes));
+        }
+    }
+
+    std::vector<StageResult> results;
+    for (const BenchmarkCase &benchmarkCase : cases)
+    {
+        std::cout << "Benchmarking " << benchmarkCase.name << "..." << std::endl;
+        runBenchmarkCase(benchmarkCase, options, scrapFolderPath, results);
+    }
+
+    std::cout << std::endl
+              << std::left << std::setw(32) << "case" << std::setw(20) << "stage" << std::right << std::setw(12) << "p50 ms"
+              << std::setw(12) << "p90 ms" << std::setw(12) << "max ms" << std::endl;
+    for (StageResult result : results)
+    {
+        std::sort(result.samples.begin(), result.samples.end());
+        std::cout << std::left << std::setw(32) << result.caseName << std::setw(20) << result.stage << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << percentile(result.samples, 50) << std::setw(12) << percentile(result.samples, 90)
+                  << std::setw(12) << result.samples.back() << std::endl;
+    }
+
+    if (!options.csvPath.empty())
+    {
+        std::ofstream csvFile(options.csvPath);
+        writeCsv(results, csvFile);
+    }
+    if (!options.jsonPath.empty())
+    {
+        std::ofstream jsonFile(options.jsonPath);
+        writeJson(results, jsonFile);
+    }
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <malloc.h>
+#include "../Version3/subpathcache.h"
+
+/**
+ * Get the bytes currently in use by the heap, including the bookkeeping of each allocation.
+ *
+ * @return size_t The number of bytes in use
+ */
+size_t heapBytesInUse()
+{
+    return mallinfo2().uordblks;
+}
+
+/**
+ * The hash the subpath cache used before the packed key, kept as the baseline of the comparison.
+ */
+struct PairHash
+{
+    template <typename T1, typename T2>
+    std::size_t operator()(const std::pair<T1, T2> &p) const
+    {
+        std::size_t h1 = std::hash<T1>{}(p.first);
+        std::size_t h2 = std::hash<T2>{}(p.second);
+        return h1 ^ (h2 << 1);
+    }
+
+    template <typename T1, typename T2, typename T3, typename T4>
+    std::size_t operator()(const std::pair<std::pair<T1, T2>, std::pair<T3, T4>> &p) const
+    {
+        std::size_t h1 = (*this)(p.first);
+        std::size_t h2 = (*this)(p.second);
+        return h1 ^ (h2 << 1);
+    }
+};
+
+using SubpathEnds = std::pair<std::pair<int, int>, std::pair<int, int>>;
+using LegacySubpathCache = std::unordered_map<SubpathEnds, std::pair<float, CompactPath>, PairHash>;
+
+/**
+ * Creates the subpaths a run would cache: each of a set of random nodes on a square grid paired with its closest
+ * nodes in both directions, with a random walk between them standing in for the searched path.
+ *
+ * @param numSubpaths The number of subpaths to create
+ * @param gridSize The number of rows and columns of the grid
+ * @param keys Set to the start and end positions of the subpaths
+ * @param paths Set to the cells of the subpaths
+ */
+void createSubpaths(size_t numSubpaths, int gridSize, std::vector<SubpathEnds> &keys, std::vector<CompactPath> &paths)
+{
+    std::mt19937 rng(412);
+    std::uniform_int_distribution<int> coordinate(0, gridSize - 1);
+    std::uniform_int_distribution<int> offset(-8, 8);
+    while (keys.size() < numSubpaths)
+    {
+        std::pair<int, int> startPos = {coordinate(rng), coordinate(rng)};
+        std::pair<int, int> endPos = {std::clamp(startPos.first + offset(rng), 0, gridSize - 1), std::clamp(startPos.second + offset(rng), 0, gridSize - 1)};
+        keys.push_back({startPos, endPos});
+        keys.push_back({endPos, startPos});
+    }
+    keys.resize(numSubpaths);
+
+    for (const SubpathEnds &key : keys)
+    {
+        std::vector<std::pair<int, int>> cells = {key.first};
+        while (cells.back() != key.second)
+        {
+            cells.push_back({cells.back().first + (key.second.first > cells.back().first) - (key.second.first < cells.back().first),
+                             cells.back().second + (key.second.second > cells.back().second) - (key.second.second < cells.back().second)});
+        }
+        paths.push_back(CompactPath(cells));
+    }
+}
+
+/**
+ * Prints one row of the comparison.
+ *
+ * @param name The name of the cache
+ * @param numEntries The number of entries inserted
+ * @param bytes The bytes held by the cache
+ * @param insertSeconds The time taken by the inserts
+ * @param numLookups The number of lookups timed
+ * @param lookupSeconds The time taken by the lookups
+ */
+void printRow(const std::string &name, size_t numEntries, size_t bytes, double insertSeconds, size_t numLookups, double lookupSeconds)
+{
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << (double)bytes / numEntries
+              << std::setw(16) << numEntries / insertSeconds / 1e6
+              << std::setw(16) << numLookups / lookupSeconds / 1e6 << std::endl;
+}
+
+/**
+ * Benchmarks the subpath cache of the Version3 program against the node-based map with the pair hash it replaced.
+ * Every subpath is inserted into each cache, then looked up several times in a shuffled order with half of the lookups
+ * missing, and the memory held per entry and the insert and lookup throughput are printed.
+ */
+int main(int argc, char **argv)
+{
+    size_t numSubpaths = argc > 1 ? std::stoul(argv[1]) : 200000;
+    int gridSize = argc > 2 ? std::stoi(argv[2]) : 2000;
+    const int numRounds = 5;
+    if (argc > 3 || numSubpaths == 0 || gridSize <= 0 || gridSize > 0xFFFF)
+    {
+        std::cout << "Usage: " << argv[0] << " [<numSubpaths> [<gridSize>]]" << std::endl;
+        return 51;
+    }
+
+    std::vector<SubpathEnds> keys;
+    std::vector<CompactPath> paths;
+    createSubpaths(numSubpaths, gridSize, keys, paths);
+
+    // Look up every subpath and a shifted copy of it that is not in the cache, in a random order
+    std::vector<SubpathEnds> lookups = keys;
+    for (const SubpathEnds &key : keys)
+    {
+        lookups.push_back({{key.first.first, key.first.second}, {key.second.first, key.second.second + gridSize}});
+    }
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(7));
+
+    std::cout << "Caching " << numSubpaths << " subpaths on a " << gridSize << "x" << gridSize << " grid, "
+              << numRounds * lookups.size() << " lookups (half missing)" << std::endl;
+    std::cout << std::left << std::setw(16) << "cache" << std::right << std::setw(14) << "bytes/entry"
+              << std::setw(16) << "M inserts/s" << std::setw(16) << "M lookups/s" << std::endl;
+
+    size_t numHits = 0;
+    {
+        size_t bytesBefore = heapBytesInUse();
+        auto insertStart = std::chrono::steady_clock::now();
+        LegacySubpathCache cache;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            cache.emplace(keys[i], std::make_pair(1.0f, paths[i]));
+        }
+        auto insertEnd = std::chrono::steady_clock::now();
+        size_t bytes = heapBytesInUse() - bytesBefore;
+
+        for (int round = 0; round < numRounds; round++)
+        {
+            for (const SubpathEnds &key : lookups)
+            {
+                numHits += cache.find(key) != cache.end();
+            }
+        }
+        auto lookupEnd = std::chrono::steady_clock::now();
+        printRow("unordered_map", cache.size(), bytes, std::chrono::duration<double>(insertEnd - insertStart).count(),
+                 numRounds * lookups.size(), std::chrono::duration<double>(lookupEnd - insertEnd).count());
+    }
+    {
+        size_t bytesBefore = heapBytesInUse();
+        auto insertStart = std::chrono::steady_clock::now();
+        SubpathCache cache;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            cache.emplace(keys[i].first, keys[i].second, 1.0f, paths[i]);
+        }
+        auto insertEnd = std::chrono::steady_clock::now();
+        size_t bytes = heapBytesInUse() - bytesBefore;
+
+        for (int round = 0; round < numRounds; round++)
+        {
+            for (const SubpathEnds &key : lookups)
+            {
+                numHits += cache.find(key.first, key.second) != nullptr;
+            }
+        }
+        auto lookupEnd = std::chrono::steady_clock::now();
+        printRow("SubpathCache", cache.size(), bytes, std::chrono::duration<double>(insertEnd - insertStart).count(),
+                 numRounds * lookups.size(), std::chrono::duration<double>(lookupEnd - insertEnd).count());
+    }
+
+    // Both caches hold the same subpaths, so they must agree on every lookup
+    if (numHits != 2 * numRounds * keys.size())
+    {
+        std::cerr << "The caches disagree on " << numHits << " hits." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Sends a request line to the server and reads its response, which ends with an empty line.
+ *
+ * @param socketFd The file descriptor of the connection to the server
+ * @param request The request line without its newline
+ * @param response The string to store the response in
+ * @return bool True if the response was received in full, false if the connection failed
+ */
+bool sendRequest(int socketFd, const std::string &request, std::string &response)
+{
+    std::string line = request + "\n";
+    for (size_t sent = 0; sent < line.size();)
+    {
+        ssize_t numSent = send(socketFd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (numSent <= 0)
+        {
+            return false;
+        }
+        sent += numSent;
+    }
+
+    response.clear();
+    char chunk[4096];
+    while (response.size() < 2 || response.compare(response.size() - 2, 2, "\n\n") != 0)
+    {
+        ssize_t numRead = recv(socketFd, chunk, sizeof(chunk), 0);
+        if (numRead <= 0)
+        {
+            return false;
+        }
+        response.append(chunk, numRead);
+    }
+    return true;
+}
+
+/**
+ * Local client for testing the query server of the Version3 program. Sends the node pair given on the command line,
+ * or every line read from standard input, and prints each response.
+ */
+int main(int argc, char **argv)
+{
+    const std::string usage = "Usage: " + std::string(argv[0]) + " <socketPath> [<node1> <node2> | stats | shutdown]";
+    if (argc < 2 || argc > 4)
+    {
+        std::cout << usage << std::endl;
+        return 51;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+
+    int socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketFd < 0 || connect(socketFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::cerr << "Error connecting to " << argv[1] << ": " << std::strerror(errno) << std::endl;
+        return 43;
+    }
+
+    std::string response;
+    if (argc > 2)
+    {
+        std::string request = argv[2];
+        for (int i = 3; i < argc; i++)
+        {
+            request += " " + std::string(argv[i]);
+        }
+        if (!sendRequest(socketFd, request, response))
+        {
+            std::cerr << "Connection to the server was lost." << std::endl;
+            return 44;
+        }
+        std::cout << response;
+    }
+    else
+    {
+        std::string request;
+        while (std::getline(std::cin, request))
+        {
+            if (!sendRequest(socketFd, request, response))
+            {
+                std::cerr << "Connection to the server was lost." << std::endl;
+                return 44;
+            }
+            std::cout << response;
+        }
+    }
+
+    close(socketFd);
+    return 0;
+}
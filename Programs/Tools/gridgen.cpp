@@ -0,0 +1,110 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include "syntheticgrid.h"
+
+/**
+ * Generates a grid of costs and a list of nodes at distinct cells for testing the programs at scale. The grid is
+ * written one row at a time, so its size is not limited by memory.
+ */
+int main(int argc, char **argv)
+{
+    const std::string usage = "Usage: " + std::string(argv[0]) + " <rows> <cols> <numNodes> <gridPath> <nodesPath> [--seed=N]"
+                              " [--distribution=uniform|clustered|walls|gradient] [--features=N] [--min-cost=X] [--max-cost=X] [--binary] [--tiled[=N]]";
+
+    std::vector<std::string> args;
+    SyntheticGridOptions options;
+    bool binary = false;
+    uint32_t tileSize = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        try
+        {
+            if (arg.rfind("--", 0) != 0)
+            {
+                args.push_back(arg);
+            }
+            else if (name == "--seed")
+            {
+                options.seed = std::stoull(value);
+            }
+            else if (name == "--distribution")
+            {
+                options.distribution = parseCostDistribution(value);
+            }
+            else if (name == "--features" && std::stoi(value) >= 0)
+            {
+                options.numFeatures = std::stoi(value);
+            }
+            else if (name == "--min-cost")
+            {
+                options.minCost = std::stof(value);
+            }
+            else if (name == "--max-cost")
+            {
+                options.maxCost = std::stof(value);
+            }
+            else if (arg == "--binary")
+            {
+                binary = true;
+            }
+            else if (arg == "--tiled")
+            {
+                tileSize = defaultGridTileSize;
+            }
+            else if (name == "--tiled" && std::stoi(value) > 0 && std::stoi(value) <= 65536)
+            {
+                tileSize = std::stoi(value);
+            }
+            else
+            {
+                throw std::invalid_argument(arg);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "Invalid option " << arg << ". " << usage << std::endl;
+            return 53;
+        }
+    }
+    if (args.size() != 5)
+    {
+        std::cout << usage << std::endl;
+        return 51;
+    }
+
+    long long numNodes;
+    try
+    {
+        options.rows = std::stoi(args[0]);
+        options.cols = std::stoi(args[1]);
+        numNodes = std::stoll(args[2]);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "The rows, columns and number of nodes must be integers. " << usage << std::endl;
+        return 52;
+    }
+
+    try
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<std::pair<int, int>> nodes = placeSyntheticNodes(options.rows, options.cols, numNodes, options.seed);
+        writeSyntheticGrid(options, args[3], binary, tileSize);
+        writeSyntheticNodes(nodes, args[4]);
+        std::cout << "Generated a " << options.rows << "x" << options.cols << " grid with " << numNodes << " nodes in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() << " s" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 54;
+    }
+
+    return 0;
+}
@@ -0,0 +1,424 @@
+#ifndef SYNTHETICGRID_H
+#define SYNTHETICGRID_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+#include <random>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include "../Version3/gridformat.h"
+
+/**
+ * How the costs of a generated grid are laid out.
+ */
+enum class CostDistribution
+{
+    Uniform,   // Independent costs over the whole range
+    Clustered, // Low costs with round hills of high cost
+    Walls,     // Low costs crossed by straight walls of the highest cost
+    Gradient   // Costs rising across the grid in a random direction, with some noise
+};
+
+/**
+ * The settings of a generated grid. The same settings always generate the same grid.
+ */
+struct SyntheticGridOptions
+{
+    int rows = 0;
+    int cols = 0;
+    CostDistribution distribution = CostDistribution::Uniform;
+    float minCost = 0;
+    float maxCost = 10;
+    uint64_t seed = 412;
+    int numFeatures = 0; // The number of hills or walls, or 0 to scale it with the grid
+};
+
+/**
+ * Parses the name of a cost distribution.
+ *
+ * @param name uniform, clustered, walls or gradient
+ * @return CostDistribution The distribution
+ */
+inline CostDistribution parseCostDistribution(const std::string &name)
+{
+    if (name == "uniform")
+    {
+        return CostDistribution::Uniform;
+    }
+    if (name == "clustered")
+    {
+        return CostDistribution::Clustered;
+    }
+    if (name == "walls")
+    {
+        return CostDistribution::Walls;
+    }
+    if (name == "gradient")
+    {
+        return CostDistribution::Gradient;
+    }
+    throw std::invalid_argument("Unknown cost distribution: " + name);
+}
+
+/**
+ * Get a random float between 0 and 1, excluding 1, from the top 24 bits of a random number, so the same seed gives the
+ * same grid with every standard library.
+ *
+ * @param rng The random number generator
+ * @return float The random float
+ */
+inline float randomUnit(std::mt19937_64 &rng)
+{
+    return static_cast<float>(rng() >> 40) * 0x1p-24f;
+}
+
+/**
+ * Get a random integer between two bounds, inclusive.
+ *
+ * @param rng The random number generator
+ * @param low The lowest integer
+ * @param high The highest integer
+ * @return int64_t The random integer
+ */
+inline int64_t randomBetween(std::mt19937_64 &rng, int64_t low, int64_t high)
+{
+    return low + static_cast<int64_t>(rng() % static_cast<uint64_t>(high - low + 1));
+}
+
+/**
+ * Generates the costs of a grid one row at a time, in order, so grids larger than memory can be written. The hills and
+ * walls are placed up front and each row only visits the ones that cross it, so a grid takes time linear in its cells.
+ */
+class SyntheticGrid
+{
+private:
+    /**
+     * A hill or wall covering a rectangle of cells.
+     */
+    struct Feature
+    {
+        int top, bottom, left, right;
+        float centerRow, centerCol, radius; // The shape of a hill, unused by walls
+    };
+
+    SyntheticGridOptions options;
+    std::mt19937_64 rng;
+    std::vector<Feature> features; // Ordered by their top row
+    std::vector<const Feature *> activeFeatures;
+    size_t nextFeature = 0;
+    int nextRow = 0;
+    float gradientRowWeight = 0, gradientColWeight = 0;
+
+    /**
+     * Places the hills of a clustered grid. Their radii grow with the grid, and there are enough of them to cover most of
+     * it, unless a number is given.
+     */
+    void placeHills()
+    {
+        int maxRadius = std::clamp(std::min(options.rows, options.cols) / 32, 2, 32);
+        int64_t numHills = options.numFeatures > 0 ? options.numFeatures : std::max<int64_t>(1, (int64_t)options.rows * options.cols / (16 * maxRadius * maxRadius));
+        for (int64_t i = 0; i < numHills; i++)
+        {
+            float radius = 2 + randomUnit(rng) * (maxRadius - 2);
+            float centerRow = randomUnit(rng) * options.rows;
+            float centerCol = randomUnit(rng) * options.cols;
+            int reach = static_cast<int>(std::ceil(3 * radius));
+            features.push_back({std::max(0, (int)centerRow - reach), std::min(options.rows - 1, (int)centerRow + reach),
+                                std::max(0, (int)centerCol - reach), std::min(options.cols - 1, (int)centerCol + reach),
+                                centerRow, centerCol, radius});
+        }
+    }
+
+    /**
+     * Places the walls of a walled grid. Each is horizontal or vertical, 1 to 3 cells thick and a quarter to three
+     * quarters of the grid long, so paths can go around them.
+     */
+    void placeWalls()
+    {
+        int64_t numWalls = options.numFeatures > 0 ? options.numFeatures : std::max(1, (options.rows + options.cols) / 16);
+        for (int64_t i = 0; i < numWalls; i++)
+        {
+            bool horizontal = rng() & 1;
+            int length = horizontal ? options.cols : options.rows;
+            int across = horizontal ? options.rows : options.cols;
+            int wallLength = static_cast<int>(randomBetween(rng, std::max(1, length / 4), std::max(1, 3 * length / 4)));
+            int start = static_cast<int>(randomBetween(rng, 0, length - wallLength));
+            int position = static_cast<int>(randomBetween(rng, 0, across - 1));
+            int thickness = std::min(static_cast<int>(randomBetween(rng, 1, 3)), across - position);
+
+            if (horizontal)
+            {
+                features.push_back({position, position + thickness - 1, start, start + wallLength - 1, 0, 0, 0});
+            }
+            else
+            {
+                features.push_back({start, start + wallLength - 1, position, position + thickness - 1, 0, 0, 0});
+            }
+        }
+    }
+
+public:
+    explicit SyntheticGrid(const SyntheticGridOptions &options) : options(options), rng(options.seed)
+    {
+        if (options.rows <= 0 || options.cols <= 0)
+        {
+            throw std::invalid_argument("Grid dimensions must be positive. Given: rows=" + std::to_string(options.rows) + ", cols=" + std::to_string(options.cols));
+        }
+        if (!(options.minCost <= options.maxCost))
+        {
+            throw std::invalid_argument("The lowest cost must not be above the highest cost.");
+        }
+
+        if (options.distribution == CostDistribution::Clustered)
+        {
+            this->placeHills();
+        }
+        else if (options.distribution == CostDistribution::Walls)
+        {
+            this->placeWalls();
+        }
+        else if (options.distribution == CostDistribution::Gradient)
+        {
+            float angle = randomUnit(rng) * 1.5707964f;
+            this->gradientRowWeight = std::cos(angle) / (std::cos(angle) + std::sin(angle));
+            this->gradientColWeight = std::sin(angle) / (std::cos(angle) + std::sin(angle));
+        }
+
+        std::sort(features.begin(), features.end(), [](const Feature &a, const Feature &b)
+                  { return a.top < b.top; });
+    }
+
+    /**
+     * Generates the costs of the next row.
+     *
+     * @param costs The vector to store the costs in, resized to the number of columns
+     * @return int The index of the row generated
+     */
+    int generateRow(std::vector<float> &costs)
+    {
+        int row = this->nextRow++;
+        float range = options.maxCost - options.minCost;
+        costs.resize(options.cols);
+
+        switch (options.distribution)
+        {
+        case CostDistribution::Uniform:
+            for (float &cost : costs)
+            {
+                cost = options.minCost + randomUnit(rng) * range;
+            }
+            break;
+        case CostDistribution::Clustered:
+            for (float &cost : costs)
+            {
+                cost = options.minCost + randomUnit(rng) * range * 0.1f;
+            }
+            break;
+        case CostDistribution::Walls:
+            for (float &cost : costs)
+            {
+                cost = options.minCost + randomUnit(rng) * range * 0.25f;
+            }
+            break;
+        case CostDistribution::Gradient:
+        {
+            float rowFraction = options.rows > 1 ? (float)row / (options.rows - 1) : 0;
+            for (int col = 0; col < options.cols; col++)
+            {
+                float colFraction = options.cols > 1 ? (float)col / (options.cols - 1) : 0;
+                float fraction = gradientRowWeight * rowFraction + gradientColWeight * colFraction;
+                costs[col] = options.minCost + range * std::min(0.9f * fraction + 0.1f * randomUnit(rng), 1.0f);
+            }
+            break;
+        }
+        }
+
+        // Start the features reaching this row and stop the ones that ended above it
+        while (this->nextFeature < features.size() && features[this->nextFeature].top <= row)
+        {
+            this->activeFeatures.push_back(&features[this->nextFeature++]);
+        }
+        std::erase_if(this->activeFeatures, [row](const Feature *feature)
+                      { return feature->bottom < row; });
+
+        for (const Feature *feature : this->activeFeatures)
+        {
+            for (int col = feature->left; col <= feature->right; col++)
+            {
+                if (options.distribution == CostDistribution::Walls)
+                {
+                    costs[col] = options.maxCost;
+                    continue;
+                }
+                float rowDistance = row + 0.5f - feature->centerRow;
+                float colDistance = col + 0.5f - feature->centerCol;
+                float height = std::exp(-(rowDistance * rowDistance + colDistance * colDistance) / (2 * feature->radius * feature->radius));
+                costs[col] = std::max(costs[col], options.minCost + range * height);
+            }
+        }
+
+        return row;
+    }
+};
+
+/**
+ * Writes a generated grid to a file, as text in the format of the data sets, in the binary grid format or in the tiled
+ * grid format. A tiled grid is generated a band of tiles at a time, so only one band is held in memory.
+ *
+ * @param options The settings of the grid
+ * @param gridPath The path to the file to write
+ * @param binary Whether to write the binary format
+ * @param tileSize The width of the square tiles of the tiled format, or 0 for another format
+ */
+inline void writeSyntheticGrid(const SyntheticGridOptions &options, const std::string &gridPath, bool binary, uint32_t tileSize = 0)
+{
+    SyntheticGrid grid(options);
+    std::ofstream gridFile(gridPath, std::ios::binary);
+    if (!gridFile.is_open())
+    {
+        throw std::runtime_error("Unable to open file: " + gridPath);
+    }
+
+    std::vector<float> costs;
+    if (tileSize > 0)
+    {
+        uint32_t dimensions[3] = {static_cast<uint32_t>(options.cols), static_cast<uint32_t>(options.rows), tileSize};
+        gridFile.write(tiledGridMagic, sizeof(tiledGridMagic));
+        gridFile.write(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+
+        // The rows of a band of tiles, padded with zeros to whole tiles
+        size_t numTileCols = (options.cols + tileSize - 1) / tileSize;
+        size_t paddedCols = numTileCols * tileSize;
+        std::vector<float> band(tileSize * paddedCols);
+        for (int bandRow = 0; bandRow < options.rows; bandRow += tileSize)
+        {
+            std::fill(band.begin(), band.end(), 0.0f);
+            for (int row = bandRow; row < std::min<int>(bandRow + tileSize, options.rows); row++)
+            {
+                grid.generateRow(costs);
+                std::copy(costs.begin(), costs.end(), band.begin() + (row - bandRow) * paddedCols);
+            }
+            for (size_t tileCol = 0; tileCol < numTileCols; tileCol++)
+            {
+                for (uint32_t tileRow = 0; tileRow < tileSize; tileRow++)
+                {
+                    gridFile.write(reinterpret_cast<const char *>(band.data() + tileRow * paddedCols + tileCol * tileSize), tileSize * sizeof(float));
+                }
+            }
+        }
+    }
+    else if (binary)
+    {
+        uint32_t dimensions[2] = {static_cast<uint32_t>(options.cols), static_cast<uint32_t>(options.rows)};
+        gridFile.write(binaryGridMagic, sizeof(binaryGridMagic));
+        gridFile.write(reinterpret_cast<const char *>(dimensions), sizeof(dimensions));
+        for (int row = 0; row < options.rows; row++)
+        {
+            grid.generateRow(costs);
+            gridFile.write(reinterpret_cast<const char *>(costs.data()), costs.size() * sizeof(float));
+        }
+    }
+    else
+    {
+        // Format each row into one buffer, with 5 decimal places like the data sets
+        gridFile << options.cols << " " << options.rows << "\n";
+        std::vector<char> line;
+        for (int row = 0; row < options.rows; row++)
+        {
+            grid.generateRow(costs);
+            line.resize(costs.size() * 48 + 1);
+            char *end = line.data();
+            for (float cost : costs)
+            {
+                end = std::to_chars(end, line.data() + line.size(), cost, std::chars_format::fixed, 5).ptr;
+                *end++ = ' ';
+            }
+            *end++ = '\n';
+            gridFile.write(line.data(), end - line.data());
+        }
+    }
+
+    if (!gridFile)
+    {
+        throw std::runtime_error("Unable to write to file: " + gridPath);
+    }
+}
+
+/**
+ * Picks distinct random cells of a grid for nodes. The cells are drawn with Floyd's algorithm and then shuffled, so it
+ * takes time linear in the number of nodes however full the grid is.
+ *
+ * @param rows The number of rows of the grid
+ * @param cols The number of columns of the grid
+ * @param numNodes The number of nodes, at most the number of cells
+ * @param seed The seed of the random number generator
+ * @return std::vector<std::pair<int, int>> The row and column of each node
+ */
+inline std::vector<std::pair<int, int>> placeSyntheticNodes(int rows, int cols, int64_t numNodes, uint64_t seed)
+{
+    int64_t numCells = (int64_t)rows * cols;
+    if (numNodes < 0 || numNodes > numCells)
+    {
+        throw std::invalid_argument("The number of nodes must be between 0 and the number of cells.");
+    }
+
+    // Each step draws from one more cell, and takes the newest cell if the drawn one is taken
+    std::mt19937_64 rng(seed ^ 0x9E3779B97F4A7C15ULL);
+    std::unordered_set<int64_t> taken;
+    taken.reserve(numNodes);
+    std::vector<int64_t> cells;
+    cells.reserve(numNodes);
+    for (int64_t last = numCells - numNodes; last < numCells; last++)
+    {
+        int64_t cell = randomBetween(rng, 0, last);
+        if (!taken.insert(cell).second)
+        {
+            cell = last;
+            taken.insert(cell);
+        }
+        cells.push_back(cell);
+    }
+
+    // The draws favor late cells at the end, so shuffle them to give node indices no spatial order
+    for (int64_t i = numNodes - 1; i > 0; i--)
+    {
+        std::swap(cells[i], cells[randomBetween(rng, 0, i)]);
+    }
+
+    std::vector<std::pair<int, int>> nodes;
+    nodes.reserve(numNodes);
+    for (int64_t cell : cells)
+    {
+        nodes.push_back({static_cast<int>(cell / cols), static_cast<int>(cell % cols)});
+    }
+    return nodes;
+}
+
+/**
+ * Writes nodes to a file in the format of the data sets: their number, then the row and column of each.
+ *
+ * @param nodes The row and column of each node
+ * @param nodesPath The path to the file to write
+ */
+inline void writeSyntheticNodes(const std::vector<std::pair<int, int>> &nodes, const std::string &nodesPath)
+{
+    std::ofstream nodesFile(nodesPath);
+    if (!nodesFile.is_open())
+    {
+        throw std::runtime_error("Unable to open file: " + nodesPath);
+    }
+
+    nodesFile << nodes.size() << "\n";
+    for (const auto &[row, col] : nodes)
+    {
+        nodesFile << row << " " << col << " ";
+    }
+    nodesFile << "\n";
+}
+
+#endif // SYNTHETICGRID_H
@@ -0,0 +1,130 @@
+#include "compactpath.h"
+
+/**
+ * Encodes a path of cells.
+ *
+ * @param cells The cells of the path, each one step from the previous
+ */
+CompactPath::CompactPath(const std::vector<std::pair<int, int>> &cells)
+{
+    if (cells.empty())
+    {
+        return;
+    }
+
+    this->startCell = cells[0];
+    this->numCells = 1;
+    this->packedCodes.reserve(packedSize(cells.size() - 1));
+    for (size_t i = 1; i < cells.size(); i++)
+    {
+        std::pair<int, int> step = {cells[i].first - cells[i - 1].first, cells[i].second - cells[i - 1].second};
+        auto dir = std::find(directions.begin(), directions.end(), step);
+        if (dir == directions.end())
+        {
+            throw std::invalid_argument("Consecutive cells of a path must be adjacent. Given: (" + std::to_string(cells[i - 1].first) + ", " +
+                                        std::to_string(cells[i - 1].second) + ") and (" + std::to_string(cells[i].first) + ", " + std::to_string(cells[i].second) + ")");
+        }
+        pushStep(dir - directions.begin());
+    }
+}
+
+/**
+ * Reconstructs a path from its first cell and the packed codes of its steps, as returned by packed().
+ *
+ * @param startCell The first cell of the path
+ * @param numSteps The number of steps after the first cell
+ * @param packed The 3-bit step codes, packed least significant bit first
+ */
+CompactPath::CompactPath(std::pair<int, int> startCell, size_t numSteps, const uint8_t *packed)
+    : startCell(startCell), numCells(numSteps + 1), packedCodes(packed, packed + packedSize(numSteps))
+{
+}
+
+/**
+ * Appends a step to the path. The path must not be empty.
+ *
+ * @param code The index of the step in directions
+ */
+void CompactPath::pushStep(uint8_t code)
+{
+    size_t bit = (this->numCells - 1) * 3;
+    this->packedCodes.resize(packedSize(this->numCells));
+    this->packedCodes[bit / 8] |= code << (bit % 8);
+
+    // A code starting in the last 2 bits of a byte spills into the next one
+    if (bit % 8 > 5)
+    {
+        this->packedCodes[bit / 8 + 1] |= code >> (8 - bit % 8);
+    }
+    this->numCells++;
+}
+
+/**
+ * Appends the cells of another path after the last cell of this one. The other path must start at the last
+ * cell of this one, which is not repeated. If this path is empty, it becomes a copy of the other path.
+ *
+ * @param other The path to append
+ */
+void CompactPath::append(const CompactPath &other)
+{
+    if (this->empty())
+    {
+        *this = other;
+        return;
+    }
+
+    this->packedCodes.reserve(packedSize(this->numSteps() + other.numSteps()));
+    for (size_t step = 0; step < other.numSteps(); step++)
+    {
+        pushStep(other.code(step));
+    }
+}
+
+/**
+ * Get the last cell of the path. The path must not be empty.
+ *
+ * @return std::pair<int, int> The last cell of the path
+ */
+std::pair<int, int> CompactPath::back() const
+{
+    std::pair<int, int> cell = this->startCell;
+    for (size_t step = 0; step < numSteps(); step++)
+    {
+        const std::pair<int, int> &dir = directions[code(step)];
+        cell.first += dir.first;
+        cell.second += dir.second;
+    }
+    return cell;
+}
+
+/**
+ * Get the same cells in the opposite order. Each step is replaced by the opposite direction, which is the code
+ * mirrored in directions.
+ *
+ * @return CompactPath The path from the last cell back to the first
+ */
+CompactPath CompactPath::reversed() const
+{
+    if (empty())
+    {
+        return CompactPath();
+    }
+
+    CompactPath path(std::vector<std::pair<int, int>>{back()});
+    path.packedCodes.reserve(this->packedCodes.size());
+    for (size_t step = numSteps(); step > 0; step--)
+    {
+        path.pushStep(directions.size() - 1 - code(step - 1));
+    }
+    return path;
+}
+
+/**
+ * Decodes every cell of the path.
+ *
+ * @return std::vector<std::pair<int, int>> The cells of the path
+ */
+std::vector<std::pair<int, int>> CompactPath::decode() const
+{
+    return std::vector<std::pair<int, int>>(begin(), end());
+}
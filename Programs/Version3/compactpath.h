@@ -0,0 +1,194 @@
+#ifndef COMPACTPATH_H
+#define COMPACTPATH_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// Define direction vectors for moving in 8 possible directions on the cost grid
+const std::vector<std::pair<int, int>> directions = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+/**
+ * A path of cells on the cost grid stored as its first cell followed by one 3-bit code per step, where each code is
+ * the index of the step in directions. Consecutive cells of a grid path are always one of the 8 directions apart,
+ * so this fully describes the path in about 3 bits per cell instead of the 8 bytes of a pair of ints.
+ *
+ * The cells are decoded on the fly by iterating over the path.
+ */
+class CompactPath
+{
+private:
+    std::pair<int, int> startCell = {0, 0};
+    size_t numCells = 0;
+    std::vector<uint8_t> packedCodes;
+
+public:
+    /**
+     * Forward iterator that decodes the cells of a compact path one step at a time.
+     */
+    class Iterator
+    {
+    private:
+        const CompactPath *path;
+        size_t cellIndex;
+        std::pair<int, int> cell;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<int, int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::pair<int, int> *;
+        using reference = const std::pair<int, int> &;
+
+        Iterator(const CompactPath *path, size_t cellIndex, std::pair<int, int> cell) : path(path), cellIndex(cellIndex), cell(cell) {}
+
+        reference operator*() const { return cell; }
+        pointer operator->() const { return &cell; }
+
+        Iterator &operator++()
+        {
+            // Apply the step leading to the next cell
+            if (++cellIndex < path->numCells)
+            {
+                const std::pair<int, int> &dir = directions[path->code(cellIndex - 1)];
+                cell.first += dir.first;
+                cell.second += dir.second;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++(*this);
+            return previous;
+        }
+
+        bool operator==(const Iterator &other) const { return cellIndex == other.cellIndex; }
+        bool operator!=(const Iterator &other) const { return cellIndex != other.cellIndex; }
+    };
+
+    /**
+     * Constructs an empty path with no cells.
+     */
+    CompactPath() = default;
+
+    /**
+     * Encodes a path of cells.
+     *
+     * @param cells The cells of the path, each one step from the previous
+     */
+    explicit CompactPath(const std::vector<std::pair<int, int>> &cells);
+
+    /**
+     * Reconstructs a path from its first cell and the packed codes of its steps, as returned by packed().
+     *
+     * @param startCell The first cell of the path
+     * @param numSteps The number of steps after the first cell
+     * @param packed The 3-bit step codes, packed least significant bit first
+     */
+    CompactPath(std::pair<int, int> startCell, size_t numSteps, const uint8_t *packed);
+
+    /**
+     * Appends a step to the path. The path must not be empty.
+     *
+     * @param code The index of the step in directions
+     */
+    void pushStep(uint8_t code);
+
+    /**
+     * Appends the cells of another path after the last cell of this one. The other path must start at the last
+     * cell of this one, which is not repeated. If this path is empty, it becomes a copy of the other path.
+     *
+     * @param other The path to append
+     */
+    void append(const CompactPath &other);
+
+    /**
+     * Get the code of a step.
+     *
+     * @param step The index of the step
+     * @return uint8_t The index of the step in directions
+     */
+    uint8_t code(size_t step) const
+    {
+        size_t bit = step * 3;
+        unsigned int bits = this->packedCodes[bit / 8] | (bit / 8 + 1 < this->packedCodes.size() ? this->packedCodes[bit / 8 + 1] << 8 : 0);
+        return (bits >> (bit % 8)) & 0x7;
+    }
+
+    /**
+     * Get the number of cells in the path.
+     *
+     * @return size_t The number of cells, one more than the number of steps unless the path is empty
+     */
+    size_t size() const { return this->numCells; }
+
+    /**
+     * Get whether the path has no cells.
+     *
+     * @return bool True if the path has no cells, false otherwise
+     */
+    bool empty() const { return this->numCells == 0; }
+
+    /**
+     * Get the first cell of the path.
+     *
+     * @return std::pair<int, int> The first cell of the path
+     */
+    std::pair<int, int> front() const { return this->startCell; }
+
+    /**
+     * Get the last cell of the path. The path must not be empty.
+     *
+     * @return std::pair<int, int> The last cell of the path
+     */
+    std::pair<int, int> back() const;
+
+    /**
+     * Get the number of steps after the first cell.
+     *
+     * @return size_t The number of steps
+     */
+    size_t numSteps() const { return this->numCells == 0 ? 0 : this->numCells - 1; }
+
+    /**
+     * Get the packed step codes, 3 bits per step least significant bit first.
+     *
+     * @return const std::vector<uint8_t>& The packed step codes
+     */
+    const std::vector<uint8_t> &packed() const { return this->packedCodes; }
+
+    /**
+     * Get the number of bytes needed to pack a number of steps.
+     *
+     * @param numSteps The number of steps
+     * @return size_t The number of bytes
+     */
+    static size_t packedSize(size_t numSteps) { return (numSteps * 3 + 7) / 8; }
+
+    Iterator begin() const { return Iterator(this, 0, this->startCell); }
+    Iterator end() const { return Iterator(this, this->numCells, this->startCell); }
+
+    /**
+     * Get the same cells in the opposite order. Each step is replaced by the opposite direction, which is the code
+     * mirrored in directions.
+     *
+     * @return CompactPath The path from the last cell back to the first
+     */
+    CompactPath reversed() const;
+
+    /**
+     * Decodes every cell of the path.
+     *
+     * @return std::vector<std::pair<int, int>> The cells of the path
+     */
+    std::vector<std::pair<int, int>> decode() const;
+};
+
+#endif // COMPACTPATH_H
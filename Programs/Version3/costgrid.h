@@ -0,0 +1,102 @@
+#ifndef COSTGRID_H
+#define COSTGRID_H
+
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include "tiledgrid.h"
+
+/**
+ * The cost of every cell of the grid, either loaded into memory row by row or read a tile at a time from a tiled grid
+ * file through its tile cache. Searches read the cells of a tiled grid through a TileCursor of their own and the cells
+ * of a loaded grid directly, while the rest of the program reads single cells through cost.
+ */
+class CostGrid
+{
+private:
+    std::vector<std::vector<float>> cells;
+    std::unique_ptr<TiledGrid> tiles;
+
+public:
+    CostGrid() = default;
+
+    /**
+     * Constructs a grid loaded into memory.
+     *
+     * @param cells The cost of every cell, row by row
+     */
+    explicit CostGrid(std::vector<std::vector<float>> cells) : cells(std::move(cells)) {}
+
+    /**
+     * Constructs a grid read a tile at a time.
+     *
+     * @param tiles The opened tiled grid file
+     */
+    explicit CostGrid(std::unique_ptr<TiledGrid> tiles) : tiles(std::move(tiles)) {}
+
+    /**
+     * Get the number of rows of the grid.
+     *
+     * @return int The number of rows
+     */
+    int getNumRows() const { return this->tiles ? this->tiles->getNumRows() : static_cast<int>(this->cells.size()); }
+
+    /**
+     * Get the number of columns of the grid.
+     *
+     * @return int The number of columns
+     */
+    int getNumCols() const
+    {
+        return this->tiles ? this->tiles->getNumCols() : (this->cells.empty() ? 0 : static_cast<int>(this->cells[0].size()));
+    }
+
+    /**
+     * Checks whether the grid is read a tile at a time instead of being loaded into memory.
+     *
+     * @return bool True if the grid is tiled, false otherwise
+     */
+    bool isTiled() const { return this->tiles != nullptr; }
+
+    /**
+     * Get the cost of a cell.
+     *
+     * @param row The row of the cell
+     * @param col The column of the cell
+     * @return float The cost of the cell
+     */
+    float cost(int row, int col) const { return this->tiles ? this->tiles->cost(row, col) : this->cells[row][col]; }
+
+    /**
+     * Get the cells of a grid loaded into memory.
+     *
+     * @return const std::vector<std::vector<float>>& The cost of every cell, row by row
+     */
+    const std::vector<std::vector<float>> &getCells() const
+    {
+        if (this->tiles)
+        {
+            throw std::logic_error("The cells of a tiled grid are not loaded into memory.");
+        }
+        return this->cells;
+    }
+
+    /**
+     * Get the cells of a grid loaded into memory so they can be changed.
+     *
+     * @return std::vector<std::vector<float>>& The cost of every cell, row by row
+     */
+    std::vector<std::vector<float>> &getCells()
+    {
+        return const_cast<std::vector<std::vector<float>> &>(static_cast<const CostGrid *>(this)->getCells());
+    }
+
+    /**
+     * Get the tiled grid file of a grid read a tile at a time.
+     *
+     * @return TiledGrid* The tiled grid, or nullptr if the grid is loaded into memory
+     */
+    TiledGrid *getTiles() const { return this->tiles.get(); }
+};
+
+#endif // COSTGRID_H
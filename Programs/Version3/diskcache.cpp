@@ -0,0 +1,320 @@
+#include "diskcache.h"
+
+/**
+ * Computes a 64-bit FNV-1a hash of the grid dimensions and the bit patterns of every cell cost, so any change to the
+ * grid content changes the hash. A tiled grid is hashed tile by tile as it is stored, reading each tile once.
+ *
+ * @param grid The cost grid to hash
+ * @return uint64_t The hash of the grid content
+ */
+uint64_t hashGrid(const CostGrid &grid)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    auto hashBytes = [&hash](const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+
+    uint64_t dimensions[2] = {static_cast<uint64_t>(grid.getNumRows()), static_cast<uint64_t>(grid.getNumCols())};
+    hashBytes(dimensions, sizeof(dimensions));
+    if (TiledGrid *tiles = grid.getTiles())
+    {
+        int tileSize = tiles->getTileSize();
+        for (int tileRow = 0; tileRow * tileSize < grid.getNumRows(); tileRow++)
+        {
+            for (int tileCol = 0; tileCol * tileSize < grid.getNumCols(); tileCol++)
+            {
+                std::shared_ptr<const TiledGrid::Tile> tile = tiles->getTile(tileRow, tileCol);
+                hashBytes(tile->data(), tile->size() * sizeof(float));
+            }
+        }
+        return hash;
+    }
+    for (const std::vector<float> &row : grid.getCells())
+    {
+        hashBytes(row.data(), row.size() * sizeof(float));
+    }
+    return hash;
+}
+
+/**
+ * Opens the cache file, creating it if it does not exist and replacing it if it was written for a different
+ * grid or corridor policy.
+ *
+ * @param cachePath The path to the cache file
+ * @param gridHash The hash of the grid content being searched
+ * @param corridorPolicy The padding of the rectangle the subpaths are searched within
+ */
+DiskSubpathCache::DiskSubpathCache(const std::string &cachePath, uint64_t gridHash, uint32_t corridorPolicy)
+    : cachePath(cachePath), gridHash(gridHash), corridorPolicy(corridorPolicy)
+{
+    while (true)
+    {
+        this->fd = open(cachePath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (this->fd < 0)
+        {
+            throw std::runtime_error("Error opening subpath cache file: " + cachePath + ": " + std::strerror(errno));
+        }
+        lockFile(F_WRLCK);
+
+        // Another run may have replaced the file between opening and locking it, so open it again until the lock is
+        // held on the file at the path
+        struct stat opened, current;
+        if (fstat(this->fd, &opened) != 0)
+        {
+            close(this->fd);
+            throw std::runtime_error("Error reading subpath cache file: " + cachePath + ": " + std::strerror(errno));
+        }
+        if (stat(cachePath.c_str(), &current) == 0 && opened.st_dev == current.st_dev && opened.st_ino == current.st_ino)
+        {
+            break;
+        }
+        close(this->fd);
+    }
+
+    // Any entry written for a different grid or corridor policy is stale, so start over in a new file
+    Header header = {};
+    bool valid = pread(this->fd, &header, sizeof(header), 0) == sizeof(header) && std::memcmp(header.magic, "SUBPATH2", 8) == 0 &&
+                 header.gridHash == gridHash && header.corridorPolicy == corridorPolicy;
+    if (!valid)
+    {
+        try
+        {
+            replaceFile();
+        }
+        catch (const std::runtime_error &)
+        {
+            close(this->fd);
+            throw;
+        }
+    }
+
+    // Index the file and drop a record left incomplete by a run that was killed while appending under the same lock,
+    // so no record completed in between is dropped with it
+    struct stat st;
+    if (fstat(this->fd, &st) == 0)
+    {
+        indexRecords(st.st_size);
+        if (static_cast<size_t>(st.st_size) > this->indexedSize && ftruncate(this->fd, this->indexedSize) != 0)
+        {
+            std::cerr << "Error truncating subpath cache file: " << cachePath << std::endl;
+        }
+    }
+    lockFile(F_UNLCK);
+}
+
+/**
+ * Writes a new file holding only the header and renames it over the cache file, keeping it write locked.
+ */
+void DiskSubpathCache::replaceFile()
+{
+    std::string tempPath = this->cachePath + ".tmp" + std::to_string(getpid());
+    int tempFd = open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (tempFd < 0)
+    {
+        throw std::runtime_error("Error creating subpath cache file: " + tempPath + ": " + std::strerror(errno));
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, "SUBPATH2", 8);
+    header.gridHash = this->gridHash;
+    header.corridorPolicy = this->corridorPolicy;
+    if (write(tempFd, &header, sizeof(header)) != sizeof(header))
+    {
+        std::string error = std::strerror(errno);
+        close(tempFd);
+        unlink(tempPath.c_str());
+        throw std::runtime_error("Error writing subpath cache file: " + tempPath + ": " + error);
+    }
+
+    // Lock the new file before it appears at the path, so no other run indexes or appends to it before this one
+    // has finished opening it
+    std::swap(this->fd, tempFd);
+    lockFile(F_WRLCK);
+    if (rename(tempPath.c_str(), this->cachePath.c_str()) != 0)
+    {
+        std::string error = std::strerror(errno);
+        close(this->fd);
+        unlink(tempPath.c_str());
+        this->fd = tempFd;
+        throw std::runtime_error("Error replacing subpath cache file: " + this->cachePath + ": " + error);
+    }
+    close(tempFd);
+}
+
+DiskSubpathCache::~DiskSubpathCache()
+{
+    if (this->mapping != nullptr)
+    {
+        munmap(const_cast<char *>(this->mapping), this->mappedSize);
+    }
+    close(this->fd);
+}
+
+/**
+ * Sets a lock over the whole file that is held per process, so it also excludes processes forked from this one.
+ *
+ * @param type F_RDLCK, F_WRLCK or F_UNLCK
+ */
+void DiskSubpathCache::lockFile(short type)
+{
+    struct flock lock = {};
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    while (fcntl(this->fd, F_SETLKW, &lock) != 0 && errno == EINTR)
+        ;
+}
+
+/**
+ * Maps the file again if it has grown and indexes the records appended since the last call.
+ */
+void DiskSubpathCache::refresh()
+{
+    // Appends hold the write lock, so the size seen under the read lock only covers complete records
+    lockFile(F_RDLCK);
+    struct stat st;
+    if (fstat(this->fd, &st) == 0)
+    {
+        indexRecords(st.st_size);
+    }
+    lockFile(F_UNLCK);
+}
+
+/**
+ * Maps the file again if it has grown past the mapping and indexes the complete records up to the given size. The
+ * caller holds a lock on the file, so no append is in progress.
+ *
+ * @param fileSize The current size of the file
+ */
+void DiskSubpathCache::indexRecords(size_t fileSize)
+{
+    if (fileSize <= std::max(this->indexedSize, sizeof(Header)))
+    {
+        this->indexedSize = std::max(this->indexedSize, sizeof(Header));
+        return;
+    }
+
+    if (fileSize > this->mappedSize)
+    {
+        if (this->mapping != nullptr)
+        {
+            munmap(const_cast<char *>(this->mapping), this->mappedSize);
+        }
+        void *mapped = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, this->fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            this->mapping = nullptr;
+            this->mappedSize = 0;
+            this->indexedSize = 0;
+            this->index.clear();
+            return;
+        }
+        this->mapping = static_cast<const char *>(mapped);
+        this->mappedSize = fileSize;
+    }
+
+    size_t offset = std::max(this->indexedSize, sizeof(Header));
+    while (offset + sizeof(Record) <= fileSize)
+    {
+        Record record;
+        std::memcpy(&record, this->mapping + offset, sizeof(record));
+        size_t recordSize = sizeof(Record) + CompactPath::packedSize(record.numSteps);
+        if (offset + recordSize > fileSize)
+        {
+            break;
+        }
+
+        this->index[{{record.startRow, record.startCol}, {record.endRow, record.endCol}}] = offset;
+        offset += recordSize;
+    }
+    this->indexedSize = offset;
+}
+
+/**
+ * Looks up the subpath between two positions.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param cost Set to the cost of the subpath on a hit
+ * @param path Set to the cells of the subpath, including both positions, on a hit
+ * @return bool True if the subpath is in the cache, false otherwise
+ */
+bool DiskSubpathCache::lookup(std::pair<int, int> startPos, std::pair<int, int> endPos, float &cost, CompactPath &path)
+{
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+
+    auto iter = this->index.find({startPos, endPos});
+    if (iter == this->index.end())
+    {
+        // Another process may have appended the subpath since the file was last indexed
+        refresh();
+        iter = this->index.find({startPos, endPos});
+        if (iter == this->index.end())
+        {
+            return false;
+        }
+    }
+
+    // Check under the read lock that the record is still in the file and holds this subpath before reading it, so a
+    // file shortened by another process is never read past its end
+    size_t offset = iter->second;
+    bool found = false;
+    lockFile(F_RDLCK);
+    struct stat st;
+    if (fstat(this->fd, &st) == 0 && offset + sizeof(Record) <= std::min(static_cast<size_t>(st.st_size), this->mappedSize))
+    {
+        Record record;
+        std::memcpy(&record, this->mapping + offset, sizeof(record));
+        size_t recordEnd = offset + sizeof(Record) + CompactPath::packedSize(record.numSteps);
+        found = record.startRow == startPos.first && record.startCol == startPos.second && record.endRow == endPos.first &&
+                record.endCol == endPos.second && recordEnd <= std::min(static_cast<size_t>(st.st_size), this->mappedSize);
+        if (found)
+        {
+            cost = record.cost;
+            path = CompactPath(startPos, record.numSteps, reinterpret_cast<const uint8_t *>(this->mapping + offset + sizeof(Record)));
+        }
+    }
+    lockFile(F_UNLCK);
+
+    if (!found)
+    {
+        this->index.erase(iter);
+    }
+    return found;
+}
+
+/**
+ * Appends the subpath between two positions to the cache file.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param cost The cost of the subpath
+ * @param path The cells of the subpath, including both positions
+ */
+void DiskSubpathCache::append(std::pair<int, int> startPos, std::pair<int, int> endPos, float cost, const CompactPath &path)
+{
+    Record record = {startPos.first, startPos.second, endPos.first, endPos.second, cost, static_cast<uint32_t>(path.numSteps())};
+
+    // Build the whole record first so it is appended with a single write
+    std::vector<char> buffer(sizeof(Record) + path.packed().size());
+    std::memcpy(buffer.data(), &record, sizeof(record));
+    std::memcpy(buffer.data() + sizeof(Record), path.packed().data(), path.packed().size());
+
+    std::lock_guard<std::mutex> lock(this->cacheMutex);
+    lockFile(F_WRLCK);
+    struct stat st;
+    if (fstat(this->fd, &st) == 0 && write(this->fd, buffer.data(), buffer.size()) != static_cast<ssize_t>(buffer.size()))
+    {
+        // Remove a partial record so the records appended after it stay aligned
+        std::cerr << "Error appending to subpath cache file: " << this->cachePath << std::endl;
+        if (ftruncate(this->fd, st.st_size) != 0)
+        {
+            std::cerr << "Error truncating subpath cache file: " << this->cachePath << std::endl;
+        }
+    }
+    lockFile(F_UNLCK);
+}
@@ -0,0 +1,139 @@
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "compactpath.h"
+#include "costgrid.h"
+
+/**
+ * Computes a 64-bit FNV-1a hash of the grid dimensions and the bit patterns of every cell cost, so any change to the
+ * grid content changes the hash. A tiled grid is hashed tile by tile as it is stored, reading each tile once.
+ *
+ * @param grid The cost grid to hash
+ * @return uint64_t The hash of the grid content
+ */
+uint64_t hashGrid(const CostGrid &grid);
+
+/**
+ * Persistent cache of subpaths shared by every run on the same grid. The file starts with a header holding the grid
+ * hash and the corridor policy the subpaths were searched with, followed by one record per subpath holding its start
+ * and end positions, its cost and its path packed as one 3-bit direction code per step. When the header does not match
+ * the grid being searched, every entry is stale and the file is replaced by a new one, so a run still using the old
+ * file never sees it emptied under it.
+ *
+ * The file is read through mmap and indexed by start and end position. Records are appended with a single write
+ * under an exclusive record lock, so processes forked from the same run can append concurrently. A lookup that misses
+ * picks up the records appended by other processes since the file was last mapped, and a hit is checked against the
+ * file under a shared lock before it is read.
+ */
+class DiskSubpathCache
+{
+private:
+    // The header at the start of the cache file
+    struct Header
+    {
+        char magic[8];           // Identifies the file as a subpath cache
+        uint64_t gridHash;       // The hash of the grid content the subpaths were searched on
+        uint32_t corridorPolicy; // The padding of the rectangle the subpaths were searched within
+        uint32_t reserved;       // Always zero
+    };
+
+    // The fixed part of a record, followed by the packed codes of its numSteps steps
+    struct Record
+    {
+        int32_t startRow, startCol, endRow, endCol;
+        float cost;
+        uint32_t numSteps;
+    };
+
+    std::string cachePath;
+    uint64_t gridHash;
+    uint32_t corridorPolicy;
+
+    int fd = -1;
+    const char *mapping = nullptr;
+    size_t mappedSize = 0;
+    size_t indexedSize = 0;
+
+    // Offset of each record in the file by its start and end positions
+    std::map<std::pair<std::pair<int, int>, std::pair<int, int>>, size_t> index;
+    std::mutex cacheMutex;
+
+    /**
+     * Maps the file again if it has grown and indexes the records appended since the last call.
+     */
+    void refresh();
+
+    /**
+     * Maps the file again if it has grown past the mapping and indexes the complete records up to the given size. The
+     * caller holds a lock on the file, so no append is in progress.
+     *
+     * @param fileSize The current size of the file
+     */
+    void indexRecords(size_t fileSize);
+
+    /**
+     * Writes a new file holding only the header and renames it over the cache file, keeping it write locked.
+     */
+    void replaceFile();
+
+    /**
+     * Sets a lock over the whole file that is held per process, so it also excludes processes forked from this one.
+     *
+     * @param type F_RDLCK, F_WRLCK or F_UNLCK
+     */
+    void lockFile(short type);
+
+public:
+    /**
+     * Opens the cache file, creating it if it does not exist and replacing it if it was written for a different
+     * grid or corridor policy.
+     *
+     * @param cachePath The path to the cache file
+     * @param gridHash The hash of the grid content being searched
+     * @param corridorPolicy The padding of the rectangle the subpaths are searched within
+     */
+    DiskSubpathCache(const std::string &cachePath, uint64_t gridHash, uint32_t corridorPolicy);
+
+    ~DiskSubpathCache();
+
+    DiskSubpathCache(const DiskSubpathCache &) = delete;
+    DiskSubpathCache &operator=(const DiskSubpathCache &) = delete;
+
+    /**
+     * Looks up the subpath between two positions.
+     *
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @param cost Set to the cost of the subpath on a hit
+     * @param path Set to the cells of the subpath, including both positions, on a hit
+     * @return bool True if the subpath is in the cache, false otherwise
+     */
+    bool lookup(std::pair<int, int> startPos, std::pair<int, int> endPos, float &cost, CompactPath &path);
+
+    /**
+     * Appends the subpath between two positions to the cache file.
+     *
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @param cost The cost of the subpath
+     * @param path The cells of the subpath, including both positions
+     */
+    void append(std::pair<int, int> startPos, std::pair<int, int> endPos, float cost, const CompactPath &path);
+};
+
+#endif // DISKCACHE_H
@@ -9,9 +9,15 @@
  * - The second line contains the row and column indices of each node, separated by spaces.
  *
  * @param nodesPath The path to the file containing the node information.
+ * @param numClosestNodes The number of closest nodes each node is connected to.
  */
-Graph::Graph(std::string nodesPath)
+Graph::Graph(std::string nodesPath, int numClosestNodes) : numClosestNodes(numClosestNodes)
 {
+    if (numClosestNodes < 1)
+    {
+        throw std::invalid_argument("The number of closest nodes must be positive. Given: " + std::to_string(numClosestNodes));
+    }
+
     // Read the nodes file
     std::ifstream nodesFile(nodesPath);
 
@@ -25,7 +31,8 @@ Graph::Graph(std::string nodesPath)
         throw std::runtime_error("Failed to parse the number of nodes from file: " + nodesPath);
     }
 
-    nodes = std::vector<Node>(numNodes);
+    this->nodeRows.resize(numNodes);
+    this->nodeCols.resize(numNodes);
 
     // Read the next line of the file to get a list of nodes' row and columns indecies separated by spaces
     std::getline(nodesFile, line);
@@ -43,63 +50,838 @@ Graph::Graph(std::string nodesPath)
             throw std::invalid_argument("Row and column indices must be non-negative. Given: row=" + std::to_string(row) + ", col=" + std::to_string(col));
         }
 
-        nodes[i] = Node{i, std::make_pair(row, col)};
+        this->nodeRows[i] = row;
+        this->nodeCols[i] = col;
     }
     nodesFile.close();
+    this->removedNodes.resize(numNodes, false);
 
     if (this->getNumNodes() < 2)
     {
-        throw std::invalid_argument("The graph must contain at least 2 nodes.");
+        throw std::invalid_argument("The graph must contain at least 2 nodes.");
+    }
+}
+
+/**
+ * The closest nodes to a node found so far, ordered by distance and then by index like the min-heap of (distance,
+ * index) pairs they replace. The distance a node must beat to be added is kept apart so scans can compare against it.
+ */
+struct ClosestNodes
+{
+    size_t k;
+    std::vector<std::pair<int, int>> nodes; // The distance and index of each closest node
+    int threshold = std::numeric_limits<int>::max(); // The distance to beat, the farthest kept once k are kept
+
+    explicit ClosestNodes(int k) : k(k)
+    {
+        this->nodes.reserve(k + 1);
+    }
+
+    /**
+     * Forgets the nodes found, to search around another node.
+     */
+    void clear()
+    {
+        this->nodes.clear();
+        this->threshold = std::numeric_limits<int>::max();
+    }
+
+    /**
+     * Adds a node if it is closer than the farthest kept, or as close with a lower index.
+     *
+     * @param distance The Manhattan distance to the node
+     * @param idx The index of the node
+     */
+    void offer(int distance, int idx)
+    {
+        std::pair<int, int> candidate = {distance, idx};
+        if (this->k == 0 || (this->nodes.size() == this->k && !(candidate < this->nodes.back())))
+        {
+            return;
+        }
+
+        this->nodes.insert(std::upper_bound(this->nodes.begin(), this->nodes.end(), candidate), candidate);
+        if (this->nodes.size() > this->k)
+        {
+            this->nodes.pop_back();
+        }
+        if (this->nodes.size() == this->k)
+        {
+            this->threshold = this->nodes.back().first;
+        }
+    }
+};
+
+/**
+ * Scans a range of nodes for the closest to a node one at a time. The nodes are scanned in order of index, so a node
+ * only needs to be closer than the farthest kept to be added.
+ *
+ * @param rows The rows of the nodes
+ * @param cols The columns of the nodes
+ * @param begin The index of the first node to scan
+ * @param end The index after the last node to scan
+ * @param self The index of the node to find the closest nodes to
+ * @param closest The closest nodes found so far
+ */
+void scanClosestNodesScalar(const int32_t *rows, const int32_t *cols, int begin, int end, int self, ClosestNodes &closest)
+{
+    int row = rows[self], col = cols[self];
+    for (int j = begin; j < end; j++)
+    {
+        int distance = std::abs(rows[j] - row) + std::abs(cols[j] - col);
+        if (distance < closest.threshold && j != self)
+        {
+            closest.offer(distance, j);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Scans every node for the closest to a node 8 at a time with AVX2. The distances of a block are compared with the
+ * distance to beat held in a register, and only the nodes that beat it are added one at a time.
+ *
+ * @param rows The rows of the nodes, aligned to 32 bytes
+ * @param cols The columns of the nodes, aligned to 32 bytes
+ * @param numNodes The number of nodes
+ * @param self The index of the node to find the closest nodes to
+ * @param closest The closest nodes found so far
+ */
+__attribute__((target("avx2"))) void scanClosestNodesAvx2(const int32_t *rows, const int32_t *cols, int numNodes, int self, ClosestNodes &closest)
+{
+    __m256i row = _mm256_set1_epi32(rows[self]);
+    __m256i col = _mm256_set1_epi32(cols[self]);
+    __m256i threshold = _mm256_set1_epi32(closest.threshold);
+
+    int j = 0;
+    for (; j + 8 <= numNodes; j += 8)
+    {
+        __m256i rowDistances = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256(reinterpret_cast<const __m256i *>(rows + j)), row));
+        __m256i colDistances = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256(reinterpret_cast<const __m256i *>(cols + j)), col));
+        __m256i distances = _mm256_add_epi32(rowDistances, colDistances);
+
+        int closer = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(threshold, distances)));
+        if (closer != 0)
+        {
+            alignas(32) int32_t blockDistances[8];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(blockDistances), distances);
+            for (; closer != 0; closer &= closer - 1)
+            {
+                int lane = __builtin_ctz(closer);
+                if (blockDistances[lane] < closest.threshold && j + lane != self)
+                {
+                    closest.offer(blockDistances[lane], j + lane);
+                }
+            }
+            threshold = _mm256_set1_epi32(closest.threshold);
+        }
+    }
+
+    scanClosestNodesScalar(rows, cols, j, numNodes, self, closest);
+}
+
+/**
+ * Scans every node for the closest to a node 4 at a time with SSE2, which every x86-64 processor has, the same way as
+ * the AVX2 scan.
+ *
+ * @param rows The rows of the nodes, aligned to 16 bytes
+ * @param cols The columns of the nodes, aligned to 16 bytes
+ * @param numNodes The number of nodes
+ * @param self The index of the node to find the closest nodes to
+ * @param closest The closest nodes found so far
+ */
+void scanClosestNodesSse2(const int32_t *rows, const int32_t *cols, int numNodes, int self, ClosestNodes &closest)
+{
+    // SSE2 has no absolute value of integers, so subtract the sign mask from the difference flipped by it
+    auto absolute = [](__m128i value)
+    {
+        __m128i sign = _mm_srai_epi32(value, 31);
+        return _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+    };
+
+    __m128i row = _mm_set1_epi32(rows[self]);
+    __m128i col = _mm_set1_epi32(cols[self]);
+    __m128i threshold = _mm_set1_epi32(closest.threshold);
+
+    int j = 0;
+    for (; j + 4 <= numNodes; j += 4)
+    {
+        __m128i rowDistances = absolute(_mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i *>(rows + j)), row));
+        __m128i colDistances = absolute(_mm_sub_epi32(_mm_load_si128(reinterpret_cast<const __m128i *>(cols + j)), col));
+        __m128i distances = _mm_add_epi32(rowDistances, colDistances);
+
+        int closer = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(threshold, distances)));
+        if (closer != 0)
+        {
+            alignas(16) int32_t blockDistances[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(blockDistances), distances);
+            for (; closer != 0; closer &= closer - 1)
+            {
+                int lane = __builtin_ctz(closer);
+                if (blockDistances[lane] < closest.threshold && j + lane != self)
+                {
+                    closest.offer(blockDistances[lane], j + lane);
+                }
+            }
+            threshold = _mm_set1_epi32(closest.threshold);
+        }
+    }
+
+    scanClosestNodesScalar(rows, cols, j, numNodes, self, closest);
+}
+
+#endif
+
+/**
+ * Scans every node for the closest to a node with the widest SIMD instructions the processor has, or one at a time
+ * on other processors.
+ *
+ * @param rows The rows of the nodes, aligned to 32 bytes
+ * @param cols The columns of the nodes, aligned to 32 bytes
+ * @param numNodes The number of nodes
+ * @param self The index of the node to find the closest nodes to
+ * @param closest The closest nodes found so far
+ */
+void scanClosestNodes(const int32_t *rows, const int32_t *cols, int numNodes, int self, ClosestNodes &closest)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if (hasAvx2)
+    {
+        scanClosestNodesAvx2(rows, cols, numNodes, self, closest);
+    }
+    else
+    {
+        scanClosestNodesSse2(rows, cols, numNodes, self, closest);
+    }
+#else
+    scanClosestNodesScalar(rows, cols, 0, numNodes, self, closest);
+#endif
+}
+
+/**
+ * A grid of square buckets over the bounding box of the nodes, sized to hold about 2 nodes each, for finding the
+ * closest nodes of large graphs without scanning every node. Nodes can be inserted and erased as the graph changes,
+ * and a node outside the bounding box grows it.
+ */
+class NodeBuckets
+{
+private:
+    const std::vector<int32_t, AlignedAllocator<int32_t>> &rows;
+    const std::vector<int32_t, AlignedAllocator<int32_t>> &cols;
+    int minRow, minCol;
+    int bucketSize;
+    int numBucketRows, numBucketCols;
+    std::vector<std::vector<int>> buckets; // The nodes of each bucket, row by row
+
+    /**
+     * Lays out the buckets over a bounding box and places every node that is not removed in them.
+     *
+     * @param minRow The first row of the bounding box
+     * @param minCol The first column of the bounding box
+     * @param maxRow The last row of the bounding box
+     * @param maxCol The last column of the bounding box
+     * @param removed Flags marking the removed nodes
+     */
+    void layOut(int minRow, int minCol, int maxRow, int maxCol, const std::vector<bool> &removed)
+    {
+        this->minRow = minRow;
+        this->minCol = minCol;
+        this->numBucketRows = (maxRow - minRow) / this->bucketSize + 1;
+        this->numBucketCols = (maxCol - minCol) / this->bucketSize + 1;
+        this->buckets = std::vector<std::vector<int>>((size_t)this->numBucketRows * this->numBucketCols);
+        for (int i = 0; i < static_cast<int>(this->rows.size()); i++)
+        {
+            if (!removed[i])
+            {
+                this->buckets[this->bucketOf(i)].push_back(i);
+            }
+        }
+    }
+
+public:
+    NodeBuckets(const std::vector<int32_t, AlignedAllocator<int32_t>> &rows, const std::vector<int32_t, AlignedAllocator<int32_t>> &cols, const std::vector<bool> &removed)
+        : rows(rows), cols(cols)
+    {
+        int minRow = std::numeric_limits<int>::max(), minCol = std::numeric_limits<int>::max(), maxRow = 0, maxCol = 0;
+        int numNodes = 0;
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            if (!removed[i])
+            {
+                minRow = std::min(minRow, rows[i]);
+                minCol = std::min(minCol, cols[i]);
+                maxRow = std::max(maxRow, rows[i]);
+                maxCol = std::max(maxCol, cols[i]);
+                numNodes++;
+            }
+        }
+        double height = maxRow - minRow + 1.0;
+        double width = maxCol - minCol + 1.0;
+        this->bucketSize = std::max(1, static_cast<int>(std::ceil(std::sqrt(2 * height * width / numNodes))));
+        this->layOut(minRow, minCol, maxRow, maxCol, removed);
+    }
+
+    /**
+     * Get the bucket of a node.
+     *
+     * @param idx The index of the node
+     * @return size_t The index of the bucket
+     */
+    size_t bucketOf(int idx) const
+    {
+        return (size_t)((this->rows[idx] - this->minRow) / this->bucketSize) * this->numBucketCols + (this->cols[idx] - this->minCol) / this->bucketSize;
+    }
+
+    /**
+     * Places a node added to the graph in its bucket, laying out the buckets again over a bounding box that
+     * includes it if it lies outside the current one.
+     *
+     * @param idx The index of the node
+     * @param removed Flags marking the removed nodes
+     */
+    void insert(int idx, const std::vector<bool> &removed)
+    {
+        int maxRow = this->minRow + this->numBucketRows * this->bucketSize - 1;
+        int maxCol = this->minCol + this->numBucketCols * this->bucketSize - 1;
+        if (this->rows[idx] < this->minRow || this->rows[idx] > maxRow || this->cols[idx] < this->minCol || this->cols[idx] > maxCol)
+        {
+            this->layOut(std::min(this->minRow, this->rows[idx]), std::min(this->minCol, this->cols[idx]), std::max(maxRow, this->rows[idx]), std::max(maxCol, this->cols[idx]), removed);
+            return;
+        }
+        this->buckets[this->bucketOf(idx)].push_back(idx);
+    }
+
+    /**
+     * Takes a node removed from the graph out of its bucket.
+     *
+     * @param idx The index of the node
+     */
+    void erase(int idx)
+    {
+        std::vector<int> &bucket = this->buckets[this->bucketOf(idx)];
+        bucket.erase(std::find(bucket.begin(), bucket.end(), idx));
+    }
+
+    /**
+     * Calls a function with every node of the buckets in a ring around a bucket.
+     *
+     * @param bucketRow The row of the bucket at the center of the ring
+     * @param bucketCol The column of the bucket at the center of the ring
+     * @param ring The distance of the ring from the center, in buckets
+     * @param function The function to call with the index of each node
+     */
+    template <typename Function>
+    void forEachNodeInRing(int bucketRow, int bucketCol, int ring, Function function) const
+    {
+        for (int r = std::max(0, bucketRow - ring); r <= std::min(this->numBucketRows - 1, bucketRow + ring); r++)
+        {
+            // Inner rows of the ring only have a bucket at each end
+            bool edgeRow = r == bucketRow - ring || r == bucketRow + ring;
+            int step = edgeRow ? 1 : 2 * ring;
+            for (int c = bucketCol - ring; c <= bucketCol + ring; c += std::max(step, 1))
+            {
+                if (c < 0 || c >= this->numBucketCols)
+                {
+                    continue;
+                }
+                for (int j : this->buckets[(size_t)r * this->numBucketCols + c])
+                {
+                    function(j);
+                }
+            }
+        }
+    }
+
+    /**
+     * Finds the closest nodes to a position by searching rings of buckets around its bucket. After ring r is
+     * searched, every node left is more than r bucket sizes away, so the search stops once the closest nodes are no
+     * farther.
+     *
+     * @param row The row of the position
+     * @param col The column of the position
+     * @param self The index of the node at the position, which is skipped
+     * @param closest The closest nodes found so far
+     */
+    void findClosestNodes(int row, int col, int self, ClosestNodes &closest) const
+    {
+        int bucketRow = std::clamp((row - this->minRow) / this->bucketSize, 0, this->numBucketRows - 1);
+        int bucketCol = std::clamp((col - this->minCol) / this->bucketSize, 0, this->numBucketCols - 1);
+        int maxRing = std::max({bucketRow, this->numBucketRows - 1 - bucketRow, bucketCol, this->numBucketCols - 1 - bucketCol});
+
+        for (int ring = 0; ring <= maxRing; ring++)
+        {
+            this->forEachNodeInRing(bucketRow, bucketCol, ring, [&](int j)
+                                    {
+                                        int distance = std::abs(this->rows[j] - row) + std::abs(this->cols[j] - col);
+                                        if (distance <= closest.threshold && j != self)
+                                        {
+                                            closest.offer(distance, j);
+                                        } });
+
+            if (closest.nodes.size() == closest.k && closest.threshold <= ring * this->bucketSize)
+            {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Calls a function with every node within a Manhattan distance of a node, by searching rings of buckets around
+     * its bucket until every node left is farther.
+     *
+     * @param self The index of the node, which is skipped
+     * @param radius The largest distance of the nodes to visit
+     * @param function The function to call with the index and the distance of each node
+     */
+    template <typename Function>
+    void forEachNodeWithin(int self, int radius, Function function) const
+    {
+        int row = this->rows[self], col = this->cols[self];
+        int bucketRow = (row - this->minRow) / this->bucketSize;
+        int bucketCol = (col - this->minCol) / this->bucketSize;
+        int maxRing = std::max({bucketRow, this->numBucketRows - 1 - bucketRow, bucketCol, this->numBucketCols - 1 - bucketCol});
+
+        // Nodes in ring r are more than (r - 1) bucket sizes away
+        for (int ring = 0; ring <= maxRing && (long long)(ring - 1) * this->bucketSize < radius; ring++)
+        {
+            this->forEachNodeInRing(bucketRow, bucketCol, ring, [&](int j)
+                                    {
+                                        int distance = std::abs(this->rows[j] - row) + std::abs(this->cols[j] - col);
+                                        if (distance <= radius && j != self)
+                                        {
+                                            function(j, distance);
+                                        } });
+        }
+    }
+};
+
+// Defined here, where NodeBuckets is complete
+Graph::~Graph() = default;
+
+/**
+ * Creates an adjacency list to represent the graph's edges by connecting the numClosestNodes closest
+ * nodes based on Manhattan distance. The adjacency list is a vector of nodes by in order of node idx
+ * and an inner set that contains the indices of the closest nodes. Ties in distance go to the lower index.
+ * The closest nodes are found by scanning every node with SIMD instructions, or by searching a grid of buckets
+ * around each node for graphs of more than bruteForceNeighborLimit nodes or with removed nodes.
+ *
+ * Invariants: The graph contains at least 2 nodes and the nodes list is valid.
+ *
+ * @return void, simply updates the adjList member variable
+ */
+void Graph::findClosestNodes()
+{
+    int numNodes = this->getNumNodes();
+    int k = std::min(this->numClosestNodes, numNodes - this->numRemovedNodes - 1);
+    this->numNeighborsKept = k;
+
+    // Create an adjacency list to represent the graph's edges
+    this->adjList = std::vector<std::unordered_set<int>>(numNodes);
+    this->closestNodeList = std::vector<int>((size_t)numNodes * k, -1);
+    this->kthDistanceCounts.clear();
+
+    // The scan cannot skip removed nodes, so graphs with removed nodes are searched through the buckets
+    this->nodeBuckets.reset();
+    if (numNodes > bruteForceNeighborLimit || this->numRemovedNodes > 0)
+    {
+        this->nodeBuckets = std::make_unique<NodeBuckets>(this->nodeRows, this->nodeCols, this->removedNodes);
+    }
+
+    ClosestNodes closest(k);
+    for (int i = 0; i < numNodes; ++i)
+    {
+        if (this->removedNodes[i])
+        {
+            continue;
+        }
+
+        closest.clear();
+        if (this->nodeBuckets)
+        {
+            this->nodeBuckets->findClosestNodes(this->nodeRows[i], this->nodeCols[i], i, closest);
+        }
+        else
+        {
+            scanClosestNodes(this->nodeRows.data(), this->nodeCols.data(), numNodes, i, closest);
+        }
+
+        // Add the closest nodes in order of distance, in both directions to make the graph undirected
+        for (size_t n = 0; n < closest.nodes.size(); n++)
+        {
+            int neighborIdx = closest.nodes[n].second;
+            this->closestNodeList[(size_t)i * k + n] = neighborIdx;
+            this->adjList[i].insert(neighborIdx);
+            this->adjList[neighborIdx].insert(i);
+        }
+    }
+
+    buildCompressedAdjList();
+}
+
+/**
+ * Builds the bucket index of the nodes and the counts of the distances to the farthest closest node of every node,
+ * if an earlier update did not already.
+ */
+void Graph::prepareIncrementalUpdates()
+{
+    if (!this->nodeBuckets)
+    {
+        this->nodeBuckets = std::make_unique<NodeBuckets>(this->nodeRows, this->nodeCols, this->removedNodes);
+    }
+    if (this->kthDistanceCounts.empty())
+    {
+        for (int i = 0; i < this->getNumNodes(); i++)
+        {
+            if (!this->removedNodes[i])
+            {
+                this->kthDistanceCounts[kthClosestDistance(i)]++;
+            }
+        }
+    }
+}
+
+/**
+ * Get the distance from a node to the farthest of its closest nodes.
+ *
+ * @param idx The index of the node
+ * @return int The Manhattan distance to its farthest closest node
+ */
+int Graph::kthClosestDistance(int idx) const
+{
+    int farthest = this->closestNodeList[(size_t)idx * this->numNeighborsKept + this->numNeighborsKept - 1];
+    return std::abs(this->nodeRows[farthest] - this->nodeRows[idx]) + std::abs(this->nodeCols[farthest] - this->nodeCols[idx]);
+}
+
+/**
+ * Replaces the closest nodes of a node, keeping the counts of the distances to the farthest closest node up to date,
+ * and connects the node to the new closest nodes.
+ *
+ * @param idx The index of the node
+ * @param closest The new closest nodes, by distance and then index
+ * @param update The update to record the added edges in
+ */
+void Graph::setClosestNodes(int idx, const std::vector<int> &closest, NodeUpdate &update)
+{
+    int *list = this->closestNodeList.data() + (size_t)idx * this->numNeighborsKept;
+    if (list[this->numNeighborsKept - 1] >= 0)
+    {
+        int distance = kthClosestDistance(idx);
+        if (--this->kthDistanceCounts[distance] == 0)
+        {
+            this->kthDistanceCounts.erase(distance);
+        }
+    }
+
+    std::copy(closest.begin(), closest.end(), list);
+    this->kthDistanceCounts[kthClosestDistance(idx)]++;
+
+    for (int neighborIdx : closest)
+    {
+        if (this->adjList[idx].insert(neighborIdx).second)
+        {
+            this->adjList[neighborIdx].insert(idx);
+            update.addedEdges.push_back({idx, neighborIdx});
+        }
+    }
+}
+
+/**
+ * Checks whether either of two nodes is among the closest nodes of the other, which is when they are connected.
+ *
+ * @param a The index of one node
+ * @param b The index of the other node
+ * @return bool True if the nodes should be connected, false otherwise
+ */
+bool Graph::isClosestPair(int a, int b) const
+{
+    const int *listA = this->closestNodeList.data() + (size_t)a * this->numNeighborsKept;
+    const int *listB = this->closestNodeList.data() + (size_t)b * this->numNeighborsKept;
+    return std::find(listA, listA + this->numNeighborsKept, b) != listA + this->numNeighborsKept ||
+           std::find(listB, listB + this->numNeighborsKept, a) != listB + this->numNeighborsKept;
+}
+
+/**
+ * Connects the closest nodes of every node again after the number of closest nodes kept changed, which happens when
+ * the graph has at most numClosestNodes nodes, and records how the edges changed.
+ *
+ * @param update The update to record the added and removed edges in
+ */
+void Graph::rebuildClosestNodes(NodeUpdate &update)
+{
+    std::vector<std::unordered_set<int>> oldAdjList = std::move(this->adjList);
+    findClosestNodes();
+    for (int i = 0; i < this->getNumNodes(); i++)
+    {
+        for (int j : this->adjList[i])
+        {
+            if (i < j && (static_cast<size_t>(i) >= oldAdjList.size() || oldAdjList[i].count(j) == 0))
+            {
+                update.addedEdges.push_back({i, j});
+            }
+        }
+        if (static_cast<size_t>(i) < oldAdjList.size())
+        {
+            for (int j : oldAdjList[i])
+            {
+                if (i < j && this->adjList[i].count(j) == 0)
+                {
+                    update.removedEdges.push_back({i, j});
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Adds a node to the graph and connects it without rebuilding the graph. The closest nodes of the new node are found
+ * through the bucket index, and the only other nodes whose closest nodes change are those closer to the new node
+ * than to their farthest closest node, which are found by searching the buckets within the largest such distance.
+ * Each of them swaps its farthest closest node for the new node. The edges are the same as if the graph had been
+ * built with the new node.
+ *
+ * Invariants: findClosestNodes has been called.
+ *
+ * @param row The row of the new node
+ * @param col The column of the new node
+ * @return NodeUpdate The index of the new node and the edges added and removed
+ */
+NodeUpdate Graph::addNode(int row, int col)
+{
+    if (row < 0 || col < 0)
+    {
+        throw std::invalid_argument("Row and column indices must be non-negative. Given: row=" + std::to_string(row) + ", col=" + std::to_string(col));
+    }
+
+    prepareIncrementalUpdates();
+
+    int idx = this->getNumNodes();
+    NodeUpdate update = {idx, {}, {}};
+    this->nodeRows.push_back(row);
+    this->nodeCols.push_back(col);
+    this->removedNodes.push_back(false);
+    this->nodeBuckets->insert(idx, this->removedNodes);
+
+    // Small graphs connect more nodes as they grow, which changes every node
+    if (std::min(this->numClosestNodes, idx - this->numRemovedNodes) != this->numNeighborsKept)
+    {
+        rebuildClosestNodes(update);
+        return update;
+    }
+
+    int k = this->numNeighborsKept;
+    this->adjList.emplace_back();
+    this->closestNodeList.resize(this->closestNodeList.size() + k, -1);
+
+    // Find the nodes whose closest nodes the new node joins before connecting it changes their distances
+    // The new node has the highest index, so it only displaces nodes that are strictly farther
+    std::vector<std::pair<int, int>> displaced; // The index of each node and its distance to the new node
+    this->nodeBuckets->forEachNodeWithin(idx, this->kthDistanceCounts.rbegin()->first, [this, &displaced](int j, int distance)
+                                         {
+                                             if (distance < kthClosestDistance(j))
+                                             {
+                                                 displaced.push_back({j, distance});
+                                             } });
+
+    ClosestNodes closest(k);
+    this->nodeBuckets->findClosestNodes(row, col, idx, closest);
+    std::vector<int> closestNodes;
+    for (const auto &[distance, neighborIdx] : closest.nodes)
+    {
+        closestNodes.push_back(neighborIdx);
+    }
+    setClosestNodes(idx, closestNodes, update);
+
+    for (const auto &[j, distance] : displaced)
+    {
+        // Insert the new node in order of distance and drop the farthest closest node
+        const int *list = this->closestNodeList.data() + (size_t)j * k;
+        int dropped = list[k - 1];
+        std::vector<int> newClosest;
+        bool inserted = false;
+        for (int n = 0; n < k - 1; n++)
+        {
+            int neighborIdx = list[n];
+            int neighborDistance = std::abs(this->nodeRows[neighborIdx] - this->nodeRows[j]) + std::abs(this->nodeCols[neighborIdx] - this->nodeCols[j]);
+            if (!inserted && distance < neighborDistance)
+            {
+                newClosest.push_back(idx);
+                inserted = true;
+            }
+            newClosest.push_back(neighborIdx);
+        }
+        if (!inserted)
+        {
+            newClosest.push_back(idx);
+        }
+        setClosestNodes(j, newClosest, update);
+
+        if (!isClosestPair(j, dropped))
+        {
+            this->adjList[j].erase(dropped);
+            this->adjList[dropped].erase(j);
+            update.removedEdges.push_back({j, dropped});
+        }
+    }
+
+    updateCompressedAdjList(update);
+    return update;
+}
+
+/**
+ * Removes a node from the graph and disconnects it without rebuilding the graph. The index of the node is not
+ * reused, so the indices of the other nodes stay the same. The only nodes whose closest nodes change are those that
+ * had the removed node among them, and only their closest nodes are found again through the bucket index. The edges
+ * are the same as if the graph had been built without the node.
+ *
+ * Invariants: findClosestNodes has been called.
+ *
+ * @param idx The index of the node to remove
+ * @return NodeUpdate The index of the removed node and the edges added and removed
+ */
+NodeUpdate Graph::removeNode(int idx)
+{
+    if (idx < 0 || idx >= this->getNumNodes() || this->removedNodes[idx])
+    {
+        throw std::out_of_range("Node " + std::to_string(idx) + " is not in the graph.");
+    }
+    if (this->getNumNodes() - this->numRemovedNodes <= 2)
+    {
+        throw std::invalid_argument("The graph must contain at least 2 nodes.");
+    }
+
+    prepareIncrementalUpdates();
+
+    NodeUpdate update = {idx, {}, {}};
+    int k = this->numNeighborsKept;
+
+    // The nodes that had the removed node among their closest nodes are all connected to it
+    std::vector<int> affected;
+    for (int j : this->adjList[idx])
+    {
+        const int *list = this->closestNodeList.data() + (size_t)j * k;
+        if (std::find(list, list + k, idx) != list + k)
+        {
+            affected.push_back(j);
+        }
+        this->adjList[j].erase(idx);
+        update.removedEdges.push_back({idx, j});
+    }
+    std::sort(affected.begin(), affected.end());
+
+    int distance = kthClosestDistance(idx);
+    if (--this->kthDistanceCounts[distance] == 0)
+    {
+        this->kthDistanceCounts.erase(distance);
+    }
+    this->adjList[idx].clear();
+    std::fill_n(this->closestNodeList.begin() + (size_t)idx * k, k, -1);
+    this->removedNodes[idx] = true;
+    this->numRemovedNodes++;
+    this->nodeBuckets->erase(idx);
+
+    // Small graphs connect fewer nodes as they shrink, which changes every node
+    if (std::min(this->numClosestNodes, this->getNumNodes() - this->numRemovedNodes - 1) != k)
+    {
+        rebuildClosestNodes(update);
+        return update;
+    }
+
+    // Only nodes farther than the removed node can take its place, so the other closest nodes are kept
+    ClosestNodes closest(k);
+    for (int j : affected)
+    {
+        closest.clear();
+        this->nodeBuckets->findClosestNodes(this->nodeRows[j], this->nodeCols[j], j, closest);
+        std::vector<int> closestNodes;
+        for (const auto &[neighborDistance, neighborIdx] : closest.nodes)
+        {
+            closestNodes.push_back(neighborIdx);
+        }
+        setClosestNodes(j, closestNodes, update);
+    }
+
+    updateCompressedAdjList(update);
+    return update;
+}
+
+/**
+ * Checks whether a node was removed from the graph.
+ *
+ * @param idx The index of the node
+ * @return bool True if the node was removed, false otherwise
+ */
+bool Graph::isRemoved(int idx) const
+{
+    return this->removedNodes[idx];
+}
+
+/**
+ * Rebuilds the compressed sparse row adjacency from the adjacency list, with no room left between the nodes.
+ */
+void Graph::buildCompressedAdjList()
+{
+    int numNodes = this->getNumNodes();
+    this->adjOffsets.assign(numNodes, 0);
+    this->adjDegrees.assign(numNodes, 0);
+    this->adjCapacities.assign(numNodes, 0);
+    this->adjTargets.clear();
+    this->numUnusedTargets = 0;
+
+    for (int i = 0; i < numNodes; i++)
+    {
+        this->adjOffsets[i] = this->adjTargets.size();
+        this->adjDegrees[i] = this->adjList[i].size();
+        this->adjCapacities[i] = this->adjList[i].size();
+        this->adjTargets.insert(this->adjTargets.end(), this->adjList[i].begin(), this->adjList[i].end());
     }
 }
 
 /**
- * Creates an adjacency list to represent the graph's edges by connecting the numClosestNodes closest
- * nodes based on Manhattan distance. The adjacency list is a vector of nodes by in order of node idx
- * and an inner set that contains the indices of the closest nodes.
+ * Copies the neighbors of the nodes an update changed from the adjacency list to the compressed adjacency. A node
+ * whose neighbors no longer fit in its place moves to the end with room to grow, and the compressed adjacency is
+ * rebuilt once more than half of it is left unused.
  *
- * Invariants: The graph contains at least 2 nodes and the nodes list is valid.
- *
- * @return void, simply updates the adjList member variable
+ * @param update The node added or removed and the edges added and removed
  */
-void Graph::findClosestNodes()
+void Graph::updateCompressedAdjList(const NodeUpdate &update)
 {
-    // Lambda function to calculate the Manhattan distance between two nodes
-    auto manhattanDistance = [](Node a, Node b)
+    auto copyNeighbors = [this](int idx)
     {
-        return std::abs(a.pos.first - b.pos.first) + std::abs(a.pos.second - b.pos.second);
-    };
-
-    // Create an adjacency list to represent the graph's edges
-    this->adjList = std::vector<std::unordered_set<int>>(nodes.size());
-
-    for (size_t i = 0; i < nodes.size(); ++i)
-    {
-        // Create a min priority queue to keep track of the 3 smallest distances
-        std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> minHeap;
-
-        // Go through all the other nodes and calculate the distance with the current node
-        // then add them to the queue
-        for (size_t j = 0; j < nodes.size(); ++j)
+        if (static_cast<size_t>(idx) >= this->adjOffsets.size())
         {
-            if (i != j)
-            {
-                int distance = manhattanDistance(nodes[i], nodes[j]);
-                minHeap.push({distance, j}); // Push the (distance, node idx) pair to minHeap
-            }
+            this->adjOffsets.resize(idx + 1, this->adjTargets.size());
+            this->adjDegrees.resize(idx + 1, 0);
+            this->adjCapacities.resize(idx + 1, 0);
         }
 
-        // Add the smallest numClosestNodes distances to the adjacency list
-        for (int k = 0; k < this->numClosestNodes && !minHeap.empty(); ++k)
+        const std::unordered_set<int> &neighbors = this->adjList[idx];
+        if (neighbors.size() > static_cast<size_t>(this->adjCapacities[idx]))
         {
-            int neighborIdx = minHeap.top().second;
-            minHeap.pop();
+            this->numUnusedTargets += this->adjCapacities[idx];
+            this->adjOffsets[idx] = this->adjTargets.size();
+            this->adjCapacities[idx] = 2 * neighbors.size();
+            this->adjTargets.resize(this->adjTargets.size() + this->adjCapacities[idx]);
+        }
+        std::copy(neighbors.begin(), neighbors.end(), this->adjTargets.begin() + this->adjOffsets[idx]);
+        this->adjDegrees[idx] = neighbors.size();
+    };
 
-            // Add the neighbor in both directions to make the graph undirected
-            this->adjList[i].insert(neighborIdx);
-            this->adjList[neighborIdx].insert(i);
+    copyNeighbors(update.node);
+    for (const std::vector<std::pair<int, int>> *edges : {&update.addedEdges, &update.removedEdges})
+    {
+        for (const auto &[a, b] : *edges)
+        {
+            copyNeighbors(a);
+            copyNeighbors(b);
         }
     }
+
+    if (this->numUnusedTargets > this->adjTargets.size() / 2)
+    {
+        buildCompressedAdjList();
+    }
 }
 
 /**
@@ -108,9 +890,11 @@ void Graph::findClosestNodes()
  *
  * @param start The index of the starting node
  * @param dest The index of the ending node
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
  * @return std::vector<std::vector<int>> A vector of vectors containing the valid paths found
  */
-std::vector<std::vector<int>> Graph::findValidPaths(int start, int dest)
+std::vector<std::vector<int>> Graph::findValidPaths(int start, int dest, unsigned int minNodes, unsigned int maxNodes)
 {
     if (this->adjList.size() == 0)
     {
@@ -121,9 +905,6 @@ std::vector<std::vector<int>> Graph::findValidPaths(int start, int dest)
     // Find all valid paths from the starting node to the destination node
     std::vector<std::vector<int>> validPaths;
 
-    const unsigned int minNodes = 3;
-    const unsigned int maxNodes = 5;
-
     std::vector<int> path;
     findValidPath(path, validPaths, start, dest, minNodes, maxNodes);
 
@@ -151,12 +932,12 @@ void Graph::findValidPath(std::vector<int> &path, std::vector<std::vector<int>>
     path.push_back(current);
 
 #ifdef DEBUG
-    DEBUG_FILE("Current path: ", "debug_valid_paths.txt", false);
+    DEBUG_FILE(DebugCategory::Paths, "Current path: ", "debug_valid_paths.txt", false);
     for (int node : path)
     {
-        DEBUG_FILE(std::to_string(node) + " ", "debug_valid_paths.txt", false);
+        DEBUG_FILE(DebugCategory::Paths, std::to_string(node) + " ", "debug_valid_paths.txt", false);
     }
-    DEBUG_FILE("", "debug_valid_paths.txt");
+    DEBUG_FILE(DebugCategory::Paths, "", "debug_valid_paths.txt");
 #endif
 
     // Base case: if we've reached the destination, check if the path length is valid
@@ -167,29 +948,29 @@ void Graph::findValidPath(std::vector<int> &path, std::vector<std::vector<int>>
             validPaths.push_back(path);
 
 #ifdef DEBUG
-            DEBUG_FILE("Found valid path: ", "debug_valid_paths.txt", false);
+            DEBUG_FILE(DebugCategory::Paths, "Found valid path: ", "debug_valid_paths.txt", false);
             for (int node : path)
             {
-                DEBUG_FILE(std::to_string(node) + " ", "debug_valid_paths.txt", false);
+                DEBUG_FILE(DebugCategory::Paths, std::to_string(node) + " ", "debug_valid_paths.txt", false);
             }
-            DEBUG_FILE("", "debug_valid_paths.txt");
+            DEBUG_FILE(DebugCategory::Paths, "", "debug_valid_paths.txt");
 #endif
         }
         else
         {
-            DEBUG_FILE("Path does not meet node constraints. Length: " + std::to_string(path.size()), "debug_valid_paths.txt");
+            DEBUG_FILE(DebugCategory::Paths, "Path does not meet node constraints. Length: " + std::to_string(path.size()), "debug_valid_paths.txt");
         }
     }
-    else
+    else if (path.size() < maxNodes)
     {
 
 #ifdef DEBUG
-        DEBUG_FILE("Possible neighbors: ", "debug_valid_paths.txt", false);
+        DEBUG_FILE(DebugCategory::Paths, "Possible neighbors: ", "debug_valid_paths.txt", false);
         for (int neighbor : this->adjList[current])
         {
-            DEBUG_FILE(std::to_string(neighbor) + " ", "debug_valid_paths.txt", false);
+            DEBUG_FILE(DebugCategory::Paths, std::to_string(neighbor) + " ", "debug_valid_paths.txt", false);
         }
-        DEBUG_FILE("", "debug_valid_paths.txt");
+        DEBUG_FILE(DebugCategory::Paths, "", "debug_valid_paths.txt");
 #endif
 
         // Path is not valid yet, so continue exploring the neighboring nodes
@@ -198,25 +979,460 @@ void Graph::findValidPath(std::vector<int> &path, std::vector<std::vector<int>>
             // Avoid revisiting nodes within the same path
             if (std::find(path.begin(), path.end(), neighbor) == path.end())
             {
-                DEBUG_FILE("Exploring neighbor: " + std::to_string(neighbor) + " from node: " + std::to_string(current), "debug_valid_paths.txt");
+                DEBUG_FILE(DebugCategory::Paths, "Exploring neighbor: " + std::to_string(neighbor) + " from node: " + std::to_string(current), "debug_valid_paths.txt");
                 findValidPath(path, validPaths, neighbor, dest, minNodes, maxNodes);
             }
         }
     }
 
+    else
+    {
+        DEBUG_FILE(DebugCategory::Paths, "Path reached the maximum number of nodes. Length: " + std::to_string(path.size()), "debug_valid_paths.txt");
+    }
+
     // Remove the current node from the path to backtrack
-    DEBUG_FILE("Backtracking from node: " + std::to_string(current), "debug_valid_paths.txt");
+    DEBUG_FILE(DebugCategory::Paths, "Backtracking from node: " + std::to_string(current), "debug_valid_paths.txt");
+    path.pop_back();
+}
+
+/**
+ * Find the valid paths from the starting node to the destination node using branch-and-bound. Neighbors are
+ * explored cheapest edge first and any prefix whose cost already exceeds the incumbent is cut. When the edge
+ * costs are exact, only the paths tied with the cheapest one found are returned.
+ *
+ * @param start The index of the starting node
+ * @param dest The index of the ending node
+ * @param bound The edge cost oracle and incumbent bound, updated with the final incumbent and number of cut subtrees
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @return std::vector<std::vector<int>> A vector of vectors containing the valid paths that were not pruned
+ */
+std::vector<std::vector<int>> Graph::findValidPaths(int start, int dest, PathBound &bound, unsigned int minNodes, unsigned int maxNodes)
+{
+    if (this->adjList.size() == 0)
+    {
+        std::cout << "No valid paths found in the graph as the graph has no edges." << std::endl;
+        return {};
+    }
+
+    std::vector<std::vector<int>> validPaths;
+    std::vector<float> pathCosts;
+
+    std::vector<int> path;
+    findValidPath(path, validPaths, pathCosts, start, dest, minNodes, maxNodes, bound, 0);
+
+    // Paths completed before the incumbent was tightened are dominated by the final incumbent
+    if (bound.exactCosts)
+    {
+        std::vector<std::vector<int>> cheapestPaths;
+        for (size_t i = 0; i < validPaths.size(); i++)
+        {
+            if (pathCosts[i] <= bound.incumbent)
+            {
+                cheapestPaths.push_back(validPaths[i]);
+            }
+        }
+        validPaths = cheapestPaths;
+
+        // Restore the order the unpruned enumeration would have found the tied paths in, which is the order
+        // of each step's position within the adjacency list, so ties resolve to the same path either way
+        auto enumerationOrder = [this](const std::vector<int> &nodePath)
+        {
+            std::vector<long> order;
+            for (size_t i = 0; i + 1 < nodePath.size(); i++)
+            {
+                const std::unordered_set<int> &neighbors = this->adjList[nodePath[i]];
+                order.push_back(std::distance(neighbors.begin(), neighbors.find(nodePath[i + 1])));
+            }
+            return order;
+        };
+        std::stable_sort(validPaths.begin(), validPaths.end(), [&](const std::vector<int> &a, const std::vector<int> &b)
+                         { return enumerationOrder(a) < enumerationOrder(b); });
+    }
+
+    if (validPaths.size() == 0)
+    {
+        std::cout << "No valid paths found in the graph." << std::endl;
+        return {};
+    }
+
+    return validPaths;
+}
+
+/**
+ * Recursive function to be called by the branch-and-bound findValidPaths to explore the paths from the current
+ * node to the destination node that can still beat the incumbent.
+ *
+ * @param path A vector to store the current path being explored.
+ * @param validPaths A vector of vectors to store all valid paths found.
+ * @param pathCosts A vector to store the cost of each valid path found.
+ * @param current The current node being explored.
+ * @param dest The destination node.
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @param bound The edge cost oracle and incumbent bound.
+ * @param prefixCost The accumulated cost of the path up to the current node.
+ */
+void Graph::findValidPath(std::vector<int> &path, std::vector<std::vector<int>> &validPaths, std::vector<float> &pathCosts, int current, int dest, unsigned int minNodes, unsigned int maxNodes, PathBound &bound, float prefixCost)
+{
+    path.push_back(current);
+
+    if (current == dest)
+    {
+        if (path.size() >= minNodes && path.size() <= maxNodes)
+        {
+            validPaths.push_back(path);
+            pathCosts.push_back(prefixCost);
+
+            if (bound.exactCosts && prefixCost < bound.incumbent)
+            {
+                DEBUG_FILE(DebugCategory::Paths, "Tightened incumbent to: " + std::to_string(prefixCost), "debug_valid_paths.txt");
+                bound.incumbent = prefixCost;
+            }
+        }
+    }
+    else if (path.size() < maxNodes)
+    {
+        // Order the unvisited neighbors by the cost of the edge to them so the cheapest are explored first
+        std::vector<std::pair<float, int>> candidates;
+        for (int neighbor : this->adjList[current])
+        {
+            if (std::find(path.begin(), path.end(), neighbor) == path.end())
+            {
+                candidates.push_back({prefixCost + bound.edgeCost(current, neighbor), neighbor});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (const auto &[cost, neighbor] : candidates)
+        {
+            // Cut the subtree as no path through this prefix can beat the incumbent
+            if (cost > bound.incumbent)
+            {
+                DEBUG_FILE(DebugCategory::Paths, "Pruning neighbor: " + std::to_string(neighbor) + " from node: " + std::to_string(current) + " with cost: " + std::to_string(cost), "debug_valid_paths.txt");
+                bound.prunedSubtrees++;
+                continue;
+            }
+            findValidPath(path, validPaths, pathCosts, neighbor, dest, minNodes, maxNodes, bound, cost);
+        }
+    }
+
     path.pop_back();
 }
 
 /**
- * Get the nodes in the graph.
+ * Estimates the number of valid paths from the starting node to the destination node without enumerating them.
+ * A dynamic program over hop layers counts the walks that reach each node after each hop, never passing back
+ * through the starting node or through the destination node early. Every valid path is such a walk, so the
+ * estimate is an upper bound on the number of paths findValidPaths would return.
+ *
+ * @param start The index of the starting node
+ * @param dest The index of the ending node
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @return double An upper bound on the number of valid paths, or 0 if either node is not in the graph
+ */
+double Graph::estimateValidPathCount(int start, int dest, unsigned int minNodes, unsigned int maxNodes) const
+{
+    if (this->adjList.size() == 0 || start == dest || start < 0 || start >= getNumNodes() || dest < 0 || dest >= getNumNodes())
+    {
+        return 0;
+    }
+
+    // walks[v] is the number of walks from the start that end at node v after the current number of hops
+    std::vector<double> walks(this->nodeRows.size(), 0);
+    walks[start] = 1;
+
+    double count = 0;
+    for (unsigned int numNodes = 2; numNodes <= maxNodes; numNodes++)
+    {
+        std::vector<double> nextWalks(this->nodeRows.size(), 0);
+        for (size_t u = 0; u < walks.size(); u++)
+        {
+            // Walks stop at the destination and never continue through it
+            if (walks[u] == 0 || static_cast<int>(u) == dest)
+            {
+                continue;
+            }
+            for (int v : this->adjList[u])
+            {
+                if (v != start)
+                {
+                    nextWalks[v] += walks[u];
+                }
+            }
+        }
+        walks = nextWalks;
+
+        if (numNodes >= minNodes)
+        {
+            count += walks[dest];
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Counts the valid paths from the starting node to the destination node exactly without materializing them.
+ * The count is a dynamic program over the compressed adjacency keyed by the set of visited nodes, which stays
+ * small for small node limits. Throws if either node is not in the graph.
+ *
+ * @param start The index of the starting node
+ * @param dest The index of the ending node
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @return double The number of valid paths, as a double since it grows exponentially
+ */
+double Graph::countValidPaths(int start, int dest, unsigned int minNodes, unsigned int maxNodes) const
+{
+    if (start < 0 || start >= getNumNodes() || dest < 0 || dest >= getNumNodes())
+    {
+        throw std::out_of_range("Node indices must be within the graph. Given: " + std::to_string(start) + ", " + std::to_string(dest));
+    }
+    if (this->adjTargets.size() == 0)
+    {
+        return 0;
+    }
+
+    std::vector<bool> visited(this->nodeRows.size(), false);
+    visited[start] = true;
+    std::vector<int> visitedNodes = {start};
+    std::map<std::vector<int>, double> memo;
+
+    return countValidCompletions(visited, visitedNodes, memo, start, dest, minNodes, maxNodes);
+}
+
+/**
+ * Counts the valid completions of a path prefix. Prefixes that visited the same set of nodes and end at the
+ * same node have the same completions, so the counts are memoized by visited set and current node.
+ *
+ * @param visited Flags marking the nodes visited by the prefix, including the current node.
+ * @param visitedNodes The nodes visited by the prefix in sorted order, including the current node.
+ * @param memo The memoized counts keyed by the visited nodes followed by the current node.
+ * @param current The current node being explored.
+ * @param dest The destination node.
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @return double The number of valid paths that extend the prefix.
+ */
+double Graph::countValidCompletions(std::vector<bool> &visited, std::vector<int> &visitedNodes, std::map<std::vector<int>, double> &memo, int current, int dest, unsigned int minNodes, unsigned int maxNodes) const
+{
+    // Same base cases as findValidPath: a path ends at the destination and never grows past maxNodes
+    if (current == dest)
+    {
+        return visitedNodes.size() >= minNodes && visitedNodes.size() <= maxNodes ? 1 : 0;
+    }
+    if (visitedNodes.size() >= maxNodes)
+    {
+        return 0;
+    }
+
+    std::vector<int> key = visitedNodes;
+    key.push_back(current);
+    auto iter = memo.find(key);
+    if (iter != memo.end())
+    {
+        return iter->second;
+    }
+
+    double count = 0;
+    for (int e = this->adjOffsets[current]; e < this->adjOffsets[current] + this->adjDegrees[current]; e++)
+    {
+        int neighbor = this->adjTargets[e];
+        if (visited[neighbor])
+        {
+            continue;
+        }
+
+        visited[neighbor] = true;
+        visitedNodes.insert(std::lower_bound(visitedNodes.begin(), visitedNodes.end(), neighbor), neighbor);
+        count += countValidCompletions(visited, visitedNodes, memo, neighbor, dest, minNodes, maxNodes);
+        visitedNodes.erase(std::lower_bound(visitedNodes.begin(), visitedNodes.end(), neighbor));
+        visited[neighbor] = false;
+    }
+
+    memo[key] = count;
+    return count;
+}
+
+/**
+ * Finds the k cheapest valid paths from the starting node to the destination node with Yen's algorithm, where
+ * every spur search is constrained to the node limits. The paths are returned cheapest first. Throws if either node
+ * is not in the graph.
+ *
+ * @param start The index of the starting node
+ * @param dest The index of the ending node
+ * @param edgeCost The exact cost of each edge.
+ * @param k The number of paths to find.
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @return std::vector<std::pair<float, std::vector<int>>> Up to k pairs of path cost and the nodes in the path
+ */
+std::vector<std::pair<float, std::vector<int>>> Graph::findCheapestPaths(int start, int dest, const EdgeCostOracle &edgeCost, size_t k, unsigned int minNodes, unsigned int maxNodes) const
+{
+    if (start < 0 || start >= getNumNodes() || dest < 0 || dest >= getNumNodes())
+    {
+        throw std::out_of_range("Node indices must be within the graph. Given: " + std::to_string(start) + ", " + std::to_string(dest));
+    }
+    std::vector<std::pair<float, std::vector<int>>> cheapestPaths;
+    if (this->adjTargets.size() == 0 || k == 0)
+    {
+        return cheapestPaths;
+    }
+
+    // Candidate paths that deviate from the paths found so far, ordered by cost
+    std::set<std::pair<float, std::vector<int>>> candidates;
+
+    // The first candidate is the cheapest extension of the starting node
+    std::vector<int> path = {start};
+    float bestCost = std::numeric_limits<float>::max();
+    std::vector<int> bestPath;
+    findCheapestExtension(path, dest, minNodes, maxNodes, edgeCost, 0, {}, 0, bestCost, bestPath);
+    if (!bestPath.empty())
+    {
+        candidates.insert({bestCost, bestPath});
+    }
+
+    while (cheapestPaths.size() < k && !candidates.empty())
+    {
+        cheapestPaths.push_back(*candidates.begin());
+        candidates.erase(candidates.begin());
+        const std::vector<int> previous = cheapestPaths.back().second;
+
+        // Every node of the previous path but the last is a spur node where a deviating path can branch off
+        float rootCost = 0;
+        for (size_t i = 0; i + 1 < previous.size(); i++)
+        {
+            std::vector<int> root(previous.begin(), previous.begin() + i + 1);
+
+            // Ban the next hop of every path found that shares the root, so the spur deviates from all of them
+            std::unordered_set<int> bannedHops;
+            for (const auto &[cost, found] : cheapestPaths)
+            {
+                if (found.size() > root.size() && std::equal(root.begin(), root.end(), found.begin()))
+                {
+                    bannedHops.insert(found[root.size()]);
+                }
+            }
+
+            bestCost = std::numeric_limits<float>::max();
+            bestPath.clear();
+            findCheapestExtension(root, dest, minNodes, maxNodes, edgeCost, root.size(), bannedHops, rootCost, bestCost, bestPath);
+            if (!bestPath.empty())
+            {
+                candidates.insert({bestCost, bestPath});
+            }
+
+            rootCost += edgeCost(previous[i], previous[i + 1]);
+        }
+    }
+
+    return cheapestPaths;
+}
+
+/**
+ * Recursive function to find the cheapest extension of a path prefix to the destination node, used as the spur
+ * search of findCheapestPaths. Neighbors are explored cheapest edge first and prefixes that cannot beat the best
+ * extension found so far are cut.
+ *
+ * @param path The path prefix being extended, ending at the current node.
+ * @param dest The destination node.
+ * @param minNodes The minimum number of nodes a valid path must contain.
+ * @param maxNodes The maximum number of nodes a valid path can contain.
+ * @param edgeCost The exact cost of each edge.
+ * @param spurLength The length of the prefix at which bannedHops applies.
+ * @param bannedHops The nodes that may not follow the spur node, as they lead to paths already found.
+ * @param prefixCost The accumulated cost of the path prefix.
+ * @param bestCost The cost of the cheapest extension found so far.
+ * @param bestPath The cheapest extension found so far, including the prefix.
+ */
+void Graph::findCheapestExtension(std::vector<int> &path, int dest, unsigned int minNodes, unsigned int maxNodes, const EdgeCostOracle &edgeCost, size_t spurLength, const std::unordered_set<int> &bannedHops, float prefixCost, float &bestCost, std::vector<int> &bestPath) const
+{
+    int current = path.back();
+    if (current == dest)
+    {
+        if (path.size() >= minNodes && path.size() <= maxNodes && prefixCost < bestCost)
+        {
+            bestCost = prefixCost;
+            bestPath = path;
+        }
+        return;
+    }
+    if (path.size() >= maxNodes)
+    {
+        return;
+    }
+
+    std::vector<std::pair<float, int>> candidates;
+    for (int e = this->adjOffsets[current]; e < this->adjOffsets[current] + this->adjDegrees[current]; e++)
+    {
+        int neighbor = this->adjTargets[e];
+        if (std::find(path.begin(), path.end(), neighbor) != path.end() || (path.size() == spurLength && bannedHops.count(neighbor)))
+        {
+            continue;
+        }
+        candidates.push_back({prefixCost + edgeCost(current, neighbor), neighbor});
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto &[cost, neighbor] : candidates)
+    {
+        // The candidates are sorted, so none of the remaining ones can beat the best extension either
+        if (cost >= bestCost)
+        {
+            break;
+        }
+        path.push_back(neighbor);
+        findCheapestExtension(path, dest, minNodes, maxNodes, edgeCost, spurLength, bannedHops, cost, bestCost, bestPath);
+        path.pop_back();
+    }
+}
+
+/**
+ * Get a read-only view of the row of every node by index, valid until the nodes change.
+ *
+ * @return std::span<const int32_t> The rows of the nodes.
+ */
+std::span<const int32_t> Graph::getNodeRows() const
+{
+    return this->nodeRows;
+}
+
+/**
+ * Get a read-only view of the column of every node by index, valid until the nodes change.
+ *
+ * @return std::span<const int32_t> The columns of the nodes.
+ */
+std::span<const int32_t> Graph::getNodeCols() const
+{
+    return this->nodeCols;
+}
+
+/**
+ * Get the position of a node.
+ *
+ * @param idx The index of the node
+ * @return std::pair<int, int> The row and column of the node
+ */
+std::pair<int, int> Graph::getNodePosition(int idx) const
+{
+    return {this->nodeRows[idx], this->nodeCols[idx]};
+}
+
+/**
+ * Get a read-only view of the neighbors of a node, valid until the edges change.
  *
- * @return std::vector<Node> The nodes in the graph.
+ * @param idx The index of the node
+ * @return std::span<const int> The indices of the nodes connected to the node
  */
-std::vector<Node> Graph::getNodes() const
+std::span<const int> Graph::getNeighbors(int idx) const
 {
-    return this->nodes;
+    if (static_cast<size_t>(idx) >= this->adjOffsets.size())
+    {
+        return {};
+    }
+    return std::span<const int>(this->adjTargets).subspan(this->adjOffsets[idx], this->adjDegrees[idx]);
 }
 
 /**
@@ -226,7 +1442,7 @@ std::vector<Node> Graph::getNodes() const
  */
 int Graph::getNumNodes() const
 {
-    return this->nodes.size();
+    return this->nodeRows.size();
 }
 
 /**
@@ -240,7 +1456,7 @@ std::string Graph::printNodes() const
     std::ostringstream output;
     for (int i = 0; i < this->getNumNodes(); ++i)
     {
-        output << i << " " << this->nodes[i].pos.first << " " << this->nodes[i].pos.second << "\n";
+        output << i << " " << this->nodeRows[i] << " " << this->nodeCols[i] << "\n";
     }
     return output.str();
 }
@@ -9,22 +9,211 @@
 #include <vector>
 #include <queue>
 #include <unordered_set>
+#include <map>
+#include <set>
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <span>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "testing.h"
 
-struct Node
+/**
+ * Allocates memory aligned for vector loads, so the node coordinates can be scanned with aligned SIMD loads.
+ */
+template <typename T, size_t Alignment = 32>
+struct AlignedAllocator
 {
-    int idx;
-    std::pair<int, int> pos;
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+};
+
+/**
+ * The number of nodes up to which the closest nodes are found by scanning every node with SIMD instructions. Larger
+ * graphs search a grid of buckets around each node instead.
+ */
+const int bruteForceNeighborLimit = 20000;
+
+/**
+ * Returns the cost, or a lower bound on the cost, of traveling along the edge between two nodes.
+ */
+using EdgeCostOracle = std::function<float(int from, int to)>;
+
+/**
+ * State shared across a branch-and-bound enumeration of the valid paths. A prefix is not extended
+ * once its accumulated cost exceeds the incumbent, the cost of the best complete path known so far.
+ */
+struct PathBound
+{
+    EdgeCostOracle edgeCost;                             // The cost (or a lower bound on the cost) of each edge
+    float incumbent = std::numeric_limits<float>::max(); // The cost of the best complete path known so far
+    bool exactCosts = true;                              // Whether edgeCost is exact so complete paths can tighten the incumbent
+    size_t prunedSubtrees = 0;                           // The number of prefixes that were cut instead of extended
+};
+
+class NodeBuckets;
+
+/**
+ * The edges that changed when a node was added to or removed from a graph.
+ */
+struct NodeUpdate
+{
+    int node;                                      // The index of the node added or removed
+    std::vector<std::pair<int, int>> addedEdges;   // The edges added, as pairs of node indices
+    std::vector<std::pair<int, int>> removedEdges; // The edges removed, as pairs of node indices
 };
 
 class Graph
 {
 private:
-    const int numClosestNodes = 3;
-    std::vector<Node> nodes;
+    int numClosestNodes;
+
+    // The row and column of each node by index, kept in separate aligned arrays so they can be scanned with SIMD loads
+    std::vector<int32_t, AlignedAllocator<int32_t>> nodeRows;
+    std::vector<int32_t, AlignedAllocator<int32_t>> nodeCols;
     std::vector<std::unordered_set<int>> adjList;
 
+    // Compressed sparse row copy of the adjacency list in the same neighbor order. The neighbors of node i are the
+    // adjDegrees[i] targets from adjTargets[adjOffsets[i]], in a place with room for adjCapacities[i]. Places left
+    // behind by nodes that outgrew them are counted in numUnusedTargets.
+    std::vector<int> adjOffsets;
+    std::vector<int> adjDegrees;
+    std::vector<int> adjCapacities;
+    std::vector<int> adjTargets;
+    size_t numUnusedTargets = 0;
+
+    // The closest nodes of each node in order of distance and then index, numNeighborsKept per node, or -1 for
+    // removed nodes. A node is connected to another when either is among the closest nodes of the other.
+    std::vector<int> closestNodeList;
+    int numNeighborsKept = 0;
+
+    // Removed nodes keep their index so the indices of the other nodes stay the same
+    std::vector<bool> removedNodes;
+    int numRemovedNodes = 0;
+
+    // Built by the first node added or removed and kept up to date afterwards: the bucket index of the nodes and the
+    // number of nodes by the distance to their farthest closest node
+    std::unique_ptr<NodeBuckets> nodeBuckets;
+    std::map<int, int> kthDistanceCounts;
+
+    /**
+     * Rebuilds the compressed sparse row adjacency from the adjacency list, with no room left between the nodes.
+     */
+    void buildCompressedAdjList();
+
+    /**
+     * Copies the neighbors of the nodes an update changed from the adjacency list to the compressed adjacency. A node
+     * whose neighbors no longer fit in its place moves to the end with room to grow, and the compressed adjacency is
+     * rebuilt once more than half of it is left unused.
+     *
+     * @param update The node added or removed and the edges added and removed
+     */
+    void updateCompressedAdjList(const NodeUpdate &update);
+
+    /**
+     * Builds the bucket index of the nodes and the counts of the distances to the farthest closest node of every node,
+     * if an earlier update did not already.
+     */
+    void prepareIncrementalUpdates();
+
+    /**
+     * Get the distance from a node to the farthest of its closest nodes.
+     *
+     * @param idx The index of the node
+     * @return int The Manhattan distance to its farthest closest node
+     */
+    int kthClosestDistance(int idx) const;
+
+    /**
+     * Replaces the closest nodes of a node, keeping the counts of the distances to the farthest closest node up to date,
+     * and connects the node to the new closest nodes.
+     *
+     * @param idx The index of the node
+     * @param closest The new closest nodes, by distance and then index
+     * @param update The update to record the added edges in
+     */
+    void setClosestNodes(int idx, const std::vector<int> &closest, NodeUpdate &update);
+
+    /**
+     * Checks whether either of two nodes is among the closest nodes of the other, which is when they are connected.
+     *
+     * @param a The index of one node
+     * @param b The index of the other node
+     * @return bool True if the nodes should be connected, false otherwise
+     */
+    bool isClosestPair(int a, int b) const;
+
+    /**
+     * Connects the closest nodes of every node again after the number of closest nodes kept changed, which happens when
+     * the graph has at most numClosestNodes nodes, and records how the edges changed.
+     *
+     * @param update The update to record the added and removed edges in
+     */
+    void rebuildClosestNodes(NodeUpdate &update);
+
+    /**
+     * Counts the valid completions of a path prefix. Prefixes that visited the same set of nodes and end at the
+     * same node have the same completions, so the counts are memoized by visited set and current node.
+     *
+     * @param visited Flags marking the nodes visited by the prefix, including the current node.
+     * @param visitedNodes The nodes visited by the prefix in sorted order, including the current node.
+     * @param memo The memoized counts keyed by the visited nodes followed by the current node.
+     * @param current The current node being explored.
+     * @param dest The destination node.
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @return double The number of valid paths that extend the prefix.
+     */
+    double countValidCompletions(std::vector<bool> &visited, std::vector<int> &visitedNodes, std::map<std::vector<int>, double> &memo, int current, int dest, unsigned int minNodes, unsigned int maxNodes) const;
+
+    /**
+     * Recursive function to find the cheapest extension of a path prefix to the destination node, used as the spur
+     * search of findCheapestPaths. Neighbors are explored cheapest edge first and prefixes that cannot beat the best
+     * extension found so far are cut.
+     *
+     * @param path The path prefix being extended, ending at the current node.
+     * @param dest The destination node.
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @param edgeCost The exact cost of each edge.
+     * @param spurLength The length of the prefix at which bannedHops applies.
+     * @param bannedHops The nodes that may not follow the spur node, as they lead to paths already found.
+     * @param prefixCost The accumulated cost of the path prefix.
+     * @param bestCost The cost of the cheapest extension found so far.
+     * @param bestPath The cheapest extension found so far, including the prefix.
+     */
+    void findCheapestExtension(std::vector<int> &path, int dest, unsigned int minNodes, unsigned int maxNodes, const EdgeCostOracle &edgeCost, size_t spurLength, const std::unordered_set<int> &bannedHops, float prefixCost, float &bestCost, std::vector<int> &bestPath) const;
+
 public:
     /**
      * Constructs a Graph object with the specified nodes.
@@ -35,13 +224,24 @@ public:
      * - The second line contains the row and column indices of each node, separated by spaces.
      *
      * @param nodesPath The path to the file containing the node information.
+     * @param numClosestNodes The number of closest nodes each node is connected to.
      */
-    Graph(std::string nodesPath);
+    Graph(std::string nodesPath, int numClosestNodes = 3);
+
+    ~Graph();
+
+    // The bucket index refers to the node arrays of this graph, so a graph is never copied or moved
+    Graph(const Graph &) = delete;
+    Graph &operator=(const Graph &) = delete;
+    Graph(Graph &&) = delete;
+    Graph &operator=(Graph &&) = delete;
 
     /**
      * Creates an adjacency list to represent the graph's edges by connecting the numClosestNodes closest
      * nodes based on Manhattan distance. The adjacency list is a vector of nodes by in order of node idx
-     * and an inner set that contains the indices of the closest nodes.
+     * and an inner set that contains the indices of the closest nodes. Ties in distance go to the lower index.
+     * The closest nodes are found by scanning every node with SIMD instructions, or by searching a grid of buckets
+     * around each node for graphs of more than bruteForceNeighborLimit nodes or with removed nodes.
      *
      * Invariants: The graph contains at least 2 nodes and the nodes list is valid.
      *
@@ -49,15 +249,53 @@ public:
      */
     void findClosestNodes();
 
+    /**
+     * Adds a node to the graph and connects it without rebuilding the graph. The closest nodes of the new node are found
+     * through the bucket index, and the only other nodes whose closest nodes change are those closer to the new node
+     * than to their farthest closest node, which are found by searching the buckets within the largest such distance.
+     * Each of them swaps its farthest closest node for the new node. The edges are the same as if the graph had been
+     * built with the new node.
+     *
+     * Invariants: findClosestNodes has been called.
+     *
+     * @param row The row of the new node
+     * @param col The column of the new node
+     * @return NodeUpdate The index of the new node and the edges added and removed
+     */
+    NodeUpdate addNode(int row, int col);
+
+    /**
+     * Removes a node from the graph and disconnects it without rebuilding the graph. The index of the node is not
+     * reused, so the indices of the other nodes stay the same. The only nodes whose closest nodes change are those that
+     * had the removed node among them, and only their closest nodes are found again through the bucket index. The edges
+     * are the same as if the graph had been built without the node.
+     *
+     * Invariants: findClosestNodes has been called.
+     *
+     * @param idx The index of the node to remove
+     * @return NodeUpdate The index of the removed node and the edges added and removed
+     */
+    NodeUpdate removeNode(int idx);
+
+    /**
+     * Checks whether a node was removed from the graph.
+     *
+     * @param idx The index of the node
+     * @return bool True if the node was removed, false otherwise
+     */
+    bool isRemoved(int idx) const;
+
     /**
      * Find all valid paths from the starting node to the destination node. A valid path must contain at least minNodes nodes
      * and at most maxNodes nodes.
      *
      * @param start The index of the starting node
      * @param dest The index of the ending node
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
      * @return std::vector<std::vector<int>> A vector of vectors containing the valid paths found
      */
-    std::vector<std::vector<int>> findValidPaths(int start, int dest);
+    std::vector<std::vector<int>> findValidPaths(int start, int dest, unsigned int minNodes = 3, unsigned int maxNodes = 5);
 
     /**
      * Recursive function to be called by findValidPaths to explore all possible paths from the current node to the destination node.
@@ -71,6 +309,78 @@ public:
      */
     void findValidPath(std::vector<int> &path, std::vector<std::vector<int>> &validPaths, int current, int dest, unsigned int minNodes, unsigned int maxNodes);
 
+    /**
+     * Find the valid paths from the starting node to the destination node using branch-and-bound. Neighbors are
+     * explored cheapest edge first and any prefix whose cost already exceeds the incumbent is cut. When the edge
+     * costs are exact, only the paths tied with the cheapest one found are returned.
+     *
+     * @param start The index of the starting node
+     * @param dest The index of the ending node
+     * @param bound The edge cost oracle and incumbent bound, updated with the final incumbent and number of cut subtrees
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @return std::vector<std::vector<int>> A vector of vectors containing the valid paths that were not pruned
+     */
+    std::vector<std::vector<int>> findValidPaths(int start, int dest, PathBound &bound, unsigned int minNodes = 3, unsigned int maxNodes = 5);
+
+    /**
+     * Recursive function to be called by the branch-and-bound findValidPaths to explore the paths from the current
+     * node to the destination node that can still beat the incumbent.
+     *
+     * @param path A vector to store the current path being explored.
+     * @param validPaths A vector of vectors to store all valid paths found.
+     * @param pathCosts A vector to store the cost of each valid path found.
+     * @param current The current node being explored.
+     * @param dest The destination node.
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @param bound The edge cost oracle and incumbent bound.
+     * @param prefixCost The accumulated cost of the path up to the current node.
+     */
+    void findValidPath(std::vector<int> &path, std::vector<std::vector<int>> &validPaths, std::vector<float> &pathCosts, int current, int dest, unsigned int minNodes, unsigned int maxNodes, PathBound &bound, float prefixCost);
+
+    /**
+     * Estimates the number of valid paths from the starting node to the destination node without enumerating them.
+     * A dynamic program over hop layers counts the walks that reach each node after each hop, never passing back
+     * through the starting node or through the destination node early. Every valid path is such a walk, so the
+     * estimate is an upper bound on the number of paths findValidPaths would return.
+     *
+     * @param start The index of the starting node
+     * @param dest The index of the ending node
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @return double An upper bound on the number of valid paths, or 0 if either node is not in the graph
+     */
+    double estimateValidPathCount(int start, int dest, unsigned int minNodes, unsigned int maxNodes) const;
+
+    /**
+     * Counts the valid paths from the starting node to the destination node exactly without materializing them.
+     * The count is a dynamic program over the compressed adjacency keyed by the set of visited nodes, which stays
+     * small for small node limits. Throws if either node is not in the graph.
+     *
+     * @param start The index of the starting node
+     * @param dest The index of the ending node
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @return double The number of valid paths, as a double since it grows exponentially
+     */
+    double countValidPaths(int start, int dest, unsigned int minNodes, unsigned int maxNodes) const;
+
+    /**
+     * Finds the k cheapest valid paths from the starting node to the destination node with Yen's algorithm, where
+     * every spur search is constrained to the node limits. The paths are returned cheapest first. Throws if either node
+     * is not in the graph.
+     *
+     * @param start The index of the starting node
+     * @param dest The index of the ending node
+     * @param edgeCost The exact cost of each edge.
+     * @param k The number of paths to find.
+     * @param minNodes The minimum number of nodes a valid path must contain.
+     * @param maxNodes The maximum number of nodes a valid path can contain.
+     * @return std::vector<std::pair<float, std::vector<int>>> Up to k pairs of path cost and the nodes in the path
+     */
+    std::vector<std::pair<float, std::vector<int>>> findCheapestPaths(int start, int dest, const EdgeCostOracle &edgeCost, size_t k, unsigned int minNodes, unsigned int maxNodes) const;
+
     /**
      * Get the number of nodes in the graph.
      *
@@ -79,11 +389,34 @@ public:
     int getNumNodes() const;
 
     /**
-     * Get the nodes in the graph.
+     * Get a read-only view of the row of every node by index, valid until the nodes change.
+     *
+     * @return std::span<const int32_t> The rows of the nodes.
+     */
+    std::span<const int32_t> getNodeRows() const;
+
+    /**
+     * Get a read-only view of the column of every node by index, valid until the nodes change.
+     *
+     * @return std::span<const int32_t> The columns of the nodes.
+     */
+    std::span<const int32_t> getNodeCols() const;
+
+    /**
+     * Get the position of a node.
+     *
+     * @param idx The index of the node
+     * @return std::pair<int, int> The row and column of the node
+     */
+    std::pair<int, int> getNodePosition(int idx) const;
+
+    /**
+     * Get a read-only view of the neighbors of a node, valid until the edges change.
      *
-     * @return std::vector<Node> The nodes in the graph.
+     * @param idx The index of the node
+     * @return std::span<const int> The indices of the nodes connected to the node
      */
-    std::vector<Node> getNodes() const;
+    std::span<const int> getNeighbors(int idx) const;
 
     /**
      * Outputs a string version of the nodes in the graph in the format of the node index
@@ -0,0 +1,32 @@
+#ifndef GRIDFORMAT_H
+#define GRIDFORMAT_H
+
+#include <cstdint>
+
+/**
+ * The first bytes of a binary grid file. They are followed by the width and height of the grid as 32-bit unsigned
+ * integers and every cost as a 32-bit float, row by row, all in the byte order of the machine. Binary grids are written
+ * by the grid generator and read much faster than text.
+ */
+const char binaryGridMagic[4] = {'G', 'R', 'D', 'B'};
+
+/**
+ * The first bytes of a tiled grid file. They are followed by the width and height of the grid and the width of its
+ * square tiles as 32-bit unsigned integers, then every tile as 32-bit floats, row by row within the tile and tile by
+ * tile across the grid, all in the byte order of the machine. Tiles at the right and bottom edges are padded with zeros
+ * to full size so every tile starts at a fixed offset. Tiled grids are read a tile at a time instead of being loaded,
+ * so they can be larger than memory.
+ */
+const char tiledGridMagic[4] = {'G', 'R', 'D', 'T'};
+
+/**
+ * The number of bytes before the first tile of a tiled grid file.
+ */
+const uint64_t tiledGridHeaderSize = sizeof(tiledGridMagic) + 3 * sizeof(uint32_t);
+
+/**
+ * The width of the tiles the grid generator writes by default.
+ */
+const uint32_t defaultGridTileSize = 256;
+
+#endif // GRIDFORMAT_H
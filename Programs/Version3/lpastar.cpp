@@ -0,0 +1,204 @@
+#include "lpastar.h"
+
+/**
+ * Sets up the search between two positions over a corridor of the grid. Nothing is expanded until
+ * computeShortestPath is called.
+ *
+ * @param grid The cost grid, which must outlive the search
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param startRow The first row of the corridor
+ * @param endRow The last row of the corridor
+ * @param startCol The first column of the corridor
+ * @param endCol The last column of the corridor
+ */
+IncrementalSubpathSearch::IncrementalSubpathSearch(const std::vector<std::vector<float>> &grid, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol)
+    : grid(grid), startPos(startPos), endPos(endPos), startRow(startRow), endRow(endRow), startCol(startCol), endCol(endCol), width(endCol - startCol + 1)
+{
+    if (!contains(startPos.first, startPos.second) || !contains(endPos.first, endPos.second))
+    {
+        throw std::out_of_range("The starting and ending positions of a subpath search must be in its corridor.");
+    }
+
+    size_t numCells = static_cast<size_t>(endRow - startRow + 1) * this->width;
+    this->g.assign(numCells, std::numeric_limits<float>::infinity());
+    this->rhs.assign(numCells, std::numeric_limits<float>::infinity());
+
+    // The starting position is the only cell with a known cost before anything is expanded
+    int start = cellIndex(startPos.first, startPos.second);
+    this->rhs[start] = 0;
+    this->queue.push({0, start});
+    countEvent(Counter::HeapPushes);
+}
+
+/**
+ * Recomputes the lookahead cost of a cell from its neighbors and queues it if it is inconsistent.
+ *
+ * @param cell The index of the cell
+ * @param recompute False if the lookahead cost of the cell was already lowered by the caller
+ * @return bool True if the cell was queued, false otherwise
+ */
+bool IncrementalSubpathSearch::updateCell(int cell, bool recompute)
+{
+    int row = this->startRow + cell / this->width;
+    int col = this->startCol + cell % this->width;
+
+    // The starting position costs nothing to reach, whatever its neighbors cost
+    if (recompute && (row != this->startPos.first || col != this->startPos.second))
+    {
+        float lowestNeighborCost = std::numeric_limits<float>::infinity();
+        for (const std::pair<int, int> &dir : directions)
+        {
+            int newRow = row + dir.first;
+            int newCol = col + dir.second;
+            if (contains(newRow, newCol))
+            {
+                lowestNeighborCost = std::min(lowestNeighborCost, this->g[cellIndex(newRow, newCol)]);
+            }
+        }
+        this->rhs[cell] = lowestNeighborCost + this->grid[row][col];
+    }
+
+    // A stale entry of the cell may still be queued, and is skipped once its key no longer matches
+    if (this->g[cell] != this->rhs[cell])
+    {
+        this->queue.push({key(cell), cell});
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Reports that a cell of the corridor changed cost in the grid. The lowest cost subpath is only repaired by the
+ * next call to computeShortestPath, so several changes can be reported first.
+ *
+ * @param row The row of the cell
+ * @param col The column of the cell
+ */
+void IncrementalSubpathSearch::notifyCostChanged(int row, int col)
+{
+    // Only the edges into the cell are charged its cost, so only its own lookahead cost changes
+    if (contains(row, col) && updateCell(cellIndex(row, col)))
+    {
+        countEvent(Counter::HeapPushes);
+    }
+}
+
+/**
+ * Expands inconsistent cells until the cost of the ending position is final.
+ *
+ * @return uint64_t The number of cells expanded
+ */
+uint64_t IncrementalSubpathSearch::computeShortestPath()
+{
+    int end = cellIndex(this->endPos.first, this->endPos.second);
+
+    // Count locally and record once, like aStar
+    uint64_t numExpansions = 0, numPushes = 0;
+
+    while (!this->queue.empty())
+    {
+        auto [cellKey, cell] = this->queue.top();
+
+        // Skip entries of cells that became consistent or were queued again with another key
+        if (this->g[cell] == this->rhs[cell] || cellKey != key(cell))
+        {
+            this->queue.pop();
+            continue;
+        }
+
+        // Stop once nothing left on the queue can lower the cost of the ending position
+        if (cellKey >= key(end) && this->g[end] == this->rhs[end])
+        {
+            break;
+        }
+
+        this->queue.pop();
+        numExpansions++;
+
+        int row = this->startRow + cell / this->width;
+        int col = this->startCol + cell % this->width;
+
+        if (this->g[cell] > this->rhs[cell])
+        {
+            // The cell got cheaper to reach, so settle it and relax its neighbors like the A* algorithm does
+            this->g[cell] = this->rhs[cell];
+            for (const std::pair<int, int> &dir : directions)
+            {
+                int newRow = row + dir.first;
+                int newCol = col + dir.second;
+                if (contains(newRow, newCol) && (newRow != this->startPos.first || newCol != this->startPos.second))
+                {
+                    int neighbor = cellIndex(newRow, newCol);
+                    float newCost = this->g[cell] + this->grid[newRow][newCol];
+                    if (newCost < this->rhs[neighbor])
+                    {
+                        this->rhs[neighbor] = newCost;
+                        numPushes += updateCell(neighbor, false);
+                    }
+                }
+            }
+        }
+        else
+        {
+            // The cell got more expensive to reach, so unsettle it and recompute it along with its neighbors
+            this->g[cell] = std::numeric_limits<float>::infinity();
+            numPushes += updateCell(cell);
+            for (const std::pair<int, int> &dir : directions)
+            {
+                int newRow = row + dir.first;
+                int newCol = col + dir.second;
+                if (contains(newRow, newCol))
+                {
+                    numPushes += updateCell(cellIndex(newRow, newCol));
+                }
+            }
+        }
+    }
+
+    countEvent(Counter::AStarExpansions, numExpansions);
+    countEvent(Counter::HeapPushes, numPushes);
+
+    return numExpansions;
+}
+
+/**
+ * Get the cells of the lowest cost subpath found by the last call to computeShortestPath, by walking from the
+ * ending position to the neighbor with the lowest cost from the start.
+ *
+ * @return CompactPath The cells of the subpath, including both positions
+ */
+CompactPath IncrementalSubpathSearch::path() const
+{
+    std::vector<std::pair<int, int>> cells = {this->endPos};
+    std::vector<bool> visited(this->g.size(), false);
+    visited[cellIndex(this->endPos.first, this->endPos.second)] = true;
+
+    // Cells of zero cost can tie with the cell they were reached from, so never step back onto the path
+    for (std::pair<int, int> current = this->endPos; current != this->startPos;)
+    {
+        std::pair<int, int> predecessor = {-1, -1};
+        float lowestCost = std::numeric_limits<float>::infinity();
+        for (const std::pair<int, int> &dir : directions)
+        {
+            int newRow = current.first + dir.first;
+            int newCol = current.second + dir.second;
+            if (contains(newRow, newCol) && !visited[cellIndex(newRow, newCol)] && this->g[cellIndex(newRow, newCol)] < lowestCost)
+            {
+                lowestCost = this->g[cellIndex(newRow, newCol)];
+                predecessor = {newRow, newCol};
+            }
+        }
+
+        if (predecessor.first < 0)
+        {
+            throw std::logic_error("The ending position of the subpath search is unreachable.");
+        }
+        visited[cellIndex(predecessor.first, predecessor.second)] = true;
+        cells.push_back(predecessor);
+        current = predecessor;
+    }
+
+    std::reverse(cells.begin(), cells.end());
+    return CompactPath(cells);
+}
@@ -0,0 +1,140 @@
+#ifndef LPASTAR_H
+#define LPASTAR_H
+
+#include <vector>
+#include <utility>
+#include <queue>
+#include <algorithm>
+#include <limits>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include "compactpath.h"
+#include "metrics.h"
+
+/**
+ * Lowest cost subpath search over the corridor of one subpath that can be repaired after cells of the grid change
+ * cost, using Lifelong Planning A* (LPA*). Like aStar, the search moves in the 8 directions, charges each cell
+ * entered its cost and uses no heuristic, so it expands cells in the same order as Dijkstra's algorithm.
+ *
+ * Each cell keeps its cost g from the last expansion and the one-step lookahead rhs, the cost of the cell plus the
+ * lowest g of its neighbors. Cells where they differ are inconsistent and wait on a priority queue keyed by the
+ * lower of the two. A cost change only changes the rhs of the changed cell, so repairing expands the cells whose
+ * cost from the start changed instead of the whole corridor. The search reads the grid it was constructed with, so
+ * the grid must outlive it and every change to a cell in its corridor must be reported.
+ */
+class IncrementalSubpathSearch
+{
+private:
+    // A cell on the priority queue, with the key it was pushed with and its index in the corridor
+    using QueueEntry = std::pair<float, int>;
+
+    const std::vector<std::vector<float>> &grid;
+    std::pair<int, int> startPos, endPos;
+    int startRow, endRow, startCol, endCol;
+    int width;
+
+    // The costs from the start and the one-step lookahead costs of the cells of the corridor, row by row
+    std::vector<float> g, rhs;
+
+    // Inconsistent cells, with stale entries skipped when they reach the top instead of being removed
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+    /**
+     * Get the index of a cell of the corridor.
+     *
+     * @param row The row of the cell
+     * @param col The column of the cell
+     * @return int The index of the cell in g and rhs
+     */
+    int cellIndex(int row, int col) const { return (row - this->startRow) * this->width + (col - this->startCol); }
+
+    /**
+     * Get the priority of a cell, the lower of its cost and lookahead cost.
+     *
+     * @param cell The index of the cell
+     * @return float The key of the cell
+     */
+    float key(int cell) const { return std::min(this->g[cell], this->rhs[cell]); }
+
+    /**
+     * Recomputes the lookahead cost of a cell from its neighbors and queues it if it is inconsistent.
+     *
+     * @param cell The index of the cell
+     * @param recompute False if the lookahead cost of the cell was already lowered by the caller
+     * @return bool True if the cell was queued, false otherwise
+     */
+    bool updateCell(int cell, bool recompute = true);
+
+public:
+    /**
+     * Sets up the search between two positions over a corridor of the grid. Nothing is expanded until
+     * computeShortestPath is called.
+     *
+     * @param grid The cost grid, which must outlive the search
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @param startRow The first row of the corridor
+     * @param endRow The last row of the corridor
+     * @param startCol The first column of the corridor
+     * @param endCol The last column of the corridor
+     */
+    IncrementalSubpathSearch(const std::vector<std::vector<float>> &grid, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol);
+
+    IncrementalSubpathSearch(const IncrementalSubpathSearch &) = delete;
+    IncrementalSubpathSearch &operator=(const IncrementalSubpathSearch &) = delete;
+
+    /**
+     * Checks whether a cell lies in the corridor of the search.
+     *
+     * @param row The row of the cell
+     * @param col The column of the cell
+     * @return bool True if the cell is in the corridor, false otherwise
+     */
+    bool contains(int row, int col) const
+    {
+        return row >= this->startRow && row <= this->endRow && col >= this->startCol && col <= this->endCol;
+    }
+
+    /**
+     * Reports that a cell of the corridor changed cost in the grid. The lowest cost subpath is only repaired by the
+     * next call to computeShortestPath, so several changes can be reported first.
+     *
+     * @param row The row of the cell
+     * @param col The column of the cell
+     */
+    void notifyCostChanged(int row, int col);
+
+    /**
+     * Expands inconsistent cells until the cost of the ending position is final.
+     *
+     * @return uint64_t The number of cells expanded
+     */
+    uint64_t computeShortestPath();
+
+    /**
+     * Get the cost of the lowest cost subpath found by the last call to computeShortestPath, charging every cell
+     * entered but not the starting position.
+     *
+     * @return float The cost of the subpath
+     */
+    float cost() const { return this->g[cellIndex(this->endPos.first, this->endPos.second)]; }
+
+    /**
+     * Get the cells of the lowest cost subpath found by the last call to computeShortestPath, by walking from the
+     * ending position to the neighbor with the lowest cost from the start.
+     *
+     * @return CompactPath The cells of the subpath, including both positions
+     */
+    CompactPath path() const;
+
+    /**
+     * Get the memory held by the search state.
+     *
+     * @return size_t The number of bytes held
+     */
+    size_t memoryUsage() const { return (this->g.capacity() + this->rhs.capacity()) * sizeof(float) + this->queue.size() * sizeof(QueueEntry); }
+};
+
+#endif // LPASTAR_H
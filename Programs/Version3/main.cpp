@@ -4,26 +4,329 @@
 #include <vector>
 #include <sstream>
 #include <filesystem>
+#include <iomanip>
+#include <chrono>
+#include <optional>
 #include "pathfinder.h"
+#include "server.h"
 #include "testing.h"
 
+/**
+ * Optional settings given as --name or --name=value flags after the positional arguments.
+ */
+struct Options
+{
+    bool prune = false;                            // Cost the edges up front and prune the path enumeration
+    unsigned int minNodes = 3;                     // The minimum number of nodes a valid path must contain
+    unsigned int maxNodes = 5;                     // The maximum number of nodes a valid path can contain
+    int numClosestNodes = 3;                       // The number of closest nodes each node is connected to
+    double pathBudget = 100000;                    // The estimated number of valid paths above which pruning is switched on
+    bool countOnly = false;                        // Only count the valid paths instead of finding the cheapest
+    size_t topK = 0;                               // Find this many cheapest paths instead of enumerating every valid path
+    std::string batchPath;                         // The query file of node pairs to answer against one loaded grid and graph
+    std::string socketPath;                        // The Unix domain socket to serve queries on
+    unsigned int numWorkers = 4;                   // The number of worker threads serving queries
+    unsigned int idleTimeoutSeconds = 60;          // How long a server connection may go without a request, or 0 for no limit
+    std::string diskCachePath;                     // The persistent subpath cache file shared across runs
+    std::string statsFormat;                       // The format of the phase timings and event counts reported at exit, if any
+    bool perfCounters = false;                     // Count hardware events per phase in the report
+    std::string tracePath;                         // The Chrome trace file to write the spans of every process to, if any
+    bool incremental = false;                      // Keep the state of every subpath search so cost patches repair the subpaths
+    size_t tileCacheBytes = defaultTileCacheBytes; // The memory budget of the tile cache of a tiled grid
+    size_t numForkWorkers = 0;                     // The number of worker processes forked once to search the subpaths, if any
+    unsigned int maxChildren = 0;                  // The most path processes running at once, or 0 for one per processor
+};
+
+/**
+ * Parses the value of a flag that counts something, rejecting a negative value that std::stoul would wrap around.
+ *
+ * @param value The value of the flag
+ * @return unsigned long The count
+ */
+unsigned long parseCount(const std::string &value)
+{
+    if (value.find('-') != std::string::npos)
+    {
+        throw std::invalid_argument("A count cannot be negative: " + value);
+    }
+    return std::stoul(value);
+}
+
+/**
+ * Parses a single optional flag into the options.
+ *
+ * @param arg The flag as given on the command line
+ * @param options The options to update
+ * @return bool True if the flag is known and its value is valid, false otherwise
+ */
+bool parseOption(const std::string &arg, Options &options)
+{
+    size_t equals = arg.find('=');
+    std::string name = arg.substr(0, equals);
+    std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+
+    try
+    {
+        if (name == "--prune" && value.empty())
+        {
+            options.prune = true;
+        }
+        else if (name == "--count" && value.empty())
+        {
+            options.countOnly = true;
+        }
+        else if (name == "--top-k")
+        {
+            options.topK = parseCount(value);
+        }
+        else if (name == "--batch" && !value.empty())
+        {
+            options.batchPath = value;
+        }
+        else if (name == "--serve" && !value.empty())
+        {
+            options.socketPath = value;
+        }
+        else if (name == "--workers")
+        {
+            options.numWorkers = parseCount(value);
+        }
+        else if (name == "--idle-timeout")
+        {
+            options.idleTimeoutSeconds = parseCount(value);
+        }
+        else if (name == "--disk-cache" && !value.empty())
+        {
+            options.diskCachePath = value;
+        }
+        else if (name == "--stats" && value == "json")
+        {
+            options.statsFormat = value;
+        }
+        else if (name == "--perf-counters" && value.empty())
+        {
+            options.perfCounters = true;
+        }
+        else if (name == "--trace" && !value.empty())
+        {
+            options.tracePath = value;
+        }
+        else if (name == "--incremental" && value.empty())
+        {
+            options.incremental = true;
+        }
+        else if (name == "--tile-cache" && parseCount(value) > 0)
+        {
+            options.tileCacheBytes = static_cast<size_t>(parseCount(value)) << 20;
+        }
+        else if (name == "--fork-pool" && parseCount(value) > 0)
+        {
+            options.numForkWorkers = parseCount(value);
+        }
+        else if (name == "--max-children" && parseCount(value) > 0)
+        {
+            options.maxChildren = parseCount(value);
+        }
+        else if (name == "--min-nodes")
+        {
+            options.minNodes = parseCount(value);
+        }
+        else if (name == "--max-nodes")
+        {
+            options.maxNodes = parseCount(value);
+        }
+        else if (name == "--neighbors" && parseCount(value) > 0)
+        {
+            options.numClosestNodes = std::stoi(value);
+        }
+        else if (name == "--path-budget")
+        {
+            options.pathBudget = std::stod(value);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Answers every query in a query file against one loaded grid and graph. The query file contains one pair of
+ * starting and ending node indices per line, or a `patch <path>` line that applies a cost patch to the grid before the
+ * queries after it, or an `invalidate <startRow> <startCol> <endRow> <endCol>` line that drops the cached subpaths
+ * whose corridor overlaps the rectangle, or an `add <row> <col>` or `remove <node>` line that adds a node to or
+ * removes a node from the graph. Every query is answered in this process, so the subpaths computed for one
+ * query are reused by the rest. One record per line is written to the output file and the throughput is printed.
+ *
+ * @param graph The graph to search for the paths
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param options The node limits and the path of the query file
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @param outputFilePath The path to the file where the results will be written
+ * @return int 0 on success, or 42 if the query file cannot be opened
+ */
+int runBatch(Graph &graph, CostGrid &grid, const Options &options, const std::string &scrapFolderPath, const std::string &outputFilePath)
+{
+    std::ifstream queryFile(options.batchPath);
+    if (!queryFile.is_open())
+    {
+        std::cout << "Query file at specified path does not exist" << std::endl;
+        return 42;
+    }
+
+    std::ofstream outputFile(outputFilePath);
+    auto startTime = std::chrono::steady_clock::now();
+
+    size_t numQueries = 0;
+    std::string line;
+    while (std::getline(queryFile, line))
+    {
+        std::istringstream iss(line);
+        std::string command, patchPath;
+        if (iss >> command && command == "patch" && iss >> patchPath)
+        {
+            outputFile << "Patch " << patchPath << ":" << std::endl;
+            try
+            {
+                writeCostPatchStats(applyCostPatch(grid, readCostPatch(patchPath), scrapFolderPath), outputFile);
+            }
+            catch (const std::exception &e)
+            {
+                outputFile << "Error: " << e.what() << std::endl;
+            }
+            continue;
+        }
+
+        CellRect region;
+        if (command == "invalidate" && iss >> region.startRow >> region.startCol >> region.endRow >> region.endCol)
+        {
+            outputFile << "Invalidated " << invalidateSubpaths(region) << " cached subpaths." << std::endl;
+            continue;
+        }
+
+        int row, col;
+        if (command == "add" && iss >> row >> col)
+        {
+            try
+            {
+                writeGraphUpdateStats(addGraphNode(graph, grid, row, col), true, outputFile);
+            }
+            catch (const std::exception &e)
+            {
+                outputFile << "Error: " << e.what() << std::endl;
+            }
+            continue;
+        }
+
+        int node;
+        if (command == "remove" && iss >> node)
+        {
+            try
+            {
+                writeGraphUpdateStats(removeGraphNode(graph, node), false, outputFile);
+            }
+            catch (const std::exception &e)
+            {
+                outputFile << "Error: " << e.what() << std::endl;
+            }
+            continue;
+        }
+
+        iss = std::istringstream(line);
+        int startingNode, endingNode;
+        if (!(iss >> startingNode >> endingNode))
+        {
+            continue;
+        }
+        numQueries++;
+
+        outputFile << "Query " << startingNode << " " << endingNode << ":" << std::endl;
+        try
+        {
+            LowestCostPath bestPath = findLowestCostPath(graph, grid, startingNode, endingNode, options.minNodes, options.maxNodes, scrapFolderPath);
+            PhaseTimer timer(Phase::Output);
+            outputFile << "Lowest cost path found:" << std::endl;
+            writeLowestCostPath(bestPath, outputFile);
+        }
+        catch (const std::exception &e)
+        {
+            outputFile << "Error: " << e.what() << std::endl;
+        }
+    }
+    outputFile.close();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::cout << "Answered " << numQueries << " queries in " << elapsed.count() << " s ("
+              << (elapsed.count() > 0 ? numQueries / elapsed.count() : 0) << " queries/s)." << std::endl;
+    writeSubpathCacheStats(std::cout);
+    writeTileCacheStats(grid, std::cout);
+
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     // Validate CLAs
-    const std::string usage = "Usage: " + std::string(argv[0]) + " <gridPath> <nodesPath> <node1> <node2> <scrapFolderPath> <outputFilePath>";
-    if (argc > 7)
+    const std::string usage = "Usage: " + std::string(argv[0]) + " <gridPath> <nodesPath> <node1> <node2> <scrapFolderPath> <outputFilePath>"
+                              " [--prune] [--count] [--top-k=K] [--min-nodes=N] [--max-nodes=N] [--neighbors=K] [--path-budget=N] [--disk-cache=<path>] [--stats=json] [--perf-counters] [--trace=<path>] [--tile-cache=MB] [--fork-pool=N] [--max-children=N]"
+                              "\n   or: " + std::string(argv[0]) + " <gridPath> <nodesPath> <scrapFolderPath> <outputFilePath> --batch=<queryFile>"
+                              " [--incremental] [--min-nodes=N] [--max-nodes=N] [--neighbors=K] [--disk-cache=<path>] [--stats=json] [--perf-counters] [--trace=<path>] [--tile-cache=MB]"
+                              "\n   or: " + std::string(argv[0]) + " <gridPath> <nodesPath> <scrapFolderPath> --serve=<socketPath>"
+                              " [--workers=N] [--idle-timeout=S] [--incremental] [--min-nodes=N] [--max-nodes=N] [--neighbors=K] [--disk-cache=<path>] [--stats=json] [--perf-counters] [--trace=<path>] [--tile-cache=MB]";
+
+    // Separate the optional flags from the positional arguments
+    std::vector<std::string> args;
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0)
+        {
+            args.push_back(arg);
+        }
+        else if (!parseOption(arg, options))
+        {
+            std::cout << "Invalid option " << arg << ". " << usage << std::endl;
+            return 53;
+        }
+    }
+
+    if (options.minNodes < 2 || options.maxNodes < options.minNodes)
+    {
+        std::cout << "The node limits must satisfy 2 <= min-nodes <= max-nodes. " << usage << std::endl;
+        return 54;
+    }
+
+    // A batch reads its node pairs from the query file instead of the command line and
+    // a server reads them from its socket, without an output file either
+    size_t numArgs = 6;
+    if (!options.socketPath.empty())
+    {
+        numArgs = 3;
+    }
+    else if (!options.batchPath.empty())
+    {
+        numArgs = 4;
+    }
+    if (args.size() > numArgs)
     {
         std::cout << "Too many arguments. " << usage << std::endl;
         return 51;
     }
-    else if (argc < 7)
+    else if (args.size() < numArgs)
     {
         std::cout << "Too few arguments. " << usage << std::endl;
         return 52;
     }
 
-    std::string gridPath = argv[1];
-    std::string nodesPath = argv[2];
+    std::string gridPath = args[0];
+    std::string nodesPath = args[1];
 
     // See if the grid path is a file
     std::ifstream gridFile(gridPath);
@@ -41,11 +344,18 @@ int main(int argc, char **argv)
         return 41;
     }
 
-    int startingNode = std::stoi(argv[3]);
-    int endingNode = std::stoi(argv[4]);
+    std::string scrapFolderPath = args[options.socketPath.empty() ? numArgs - 2 : numArgs - 1];
+    std::string outputFilePath = options.socketPath.empty() ? args[numArgs - 1] : "";
 
-    std::string scrapFolderPath = argv[5];
-    std::string outputFilePath = argv[6];
+    // Record the time of each phase and the events of the run, including those of forked processes, and report them at exit
+    if (!options.statsFormat.empty() || options.perfCounters)
+    {
+        enableMetrics();
+    }
+    if (options.perfCounters)
+    {
+        enableHardwareCounters();
+    }
 
     // Create the scrap folder if it does not exist
     if (!std::filesystem::exists(scrapFolderPath))
@@ -53,26 +363,124 @@ int main(int argc, char **argv)
         std::filesystem::create_directories(scrapFolderPath);
     }
 
+    // Record the spans of this process and the processes it forks, merged into one trace at exit
+    if (!options.tracePath.empty())
+    {
+        enableTracing(options.tracePath, scrapFolderPath);
+    }
+
     // Construct the cost grid
-    std::vector<std::vector<float>> grid = createCostGrid(gridPath);
+    CostGrid grid = createCostGrid(gridPath, options.tileCacheBytes);
+
+    // Reuse the subpaths searched by earlier runs on the same grid
+    if (!options.diskCachePath.empty())
+    {
+        openDiskSubpathCache(options.diskCachePath, grid);
+    }
+
+    // Retain the subpath searches of a batch or server so the cost patches it is sent repair them
+    if (options.incremental)
+    {
+        if (grid.isTiled())
+        {
+            std::cout << "--incremental needs a grid loaded into memory, not a tiled grid." << std::endl;
+            return 55;
+        }
+        enableIncrementalSubpathRepair();
+    }
 
     // Construct the graph
-    Graph graph = Graph(nodesPath);
+    std::optional<PhaseTimer> graphBuildTimer(std::in_place, Phase::GraphBuild);
+    Graph graph = Graph(nodesPath, options.numClosestNodes);
 
     if (!overlayGraph(graph, grid))
     {
         return 90;
     }
+    graphBuildTimer.reset();
 
     // Construct an adjacency list to represent the graph's edges
-    graph.findClosestNodes();
+    {
+        PhaseTimer timer(Phase::NearestNeighbors);
+        graph.findClosestNodes();
+    }
 
 #ifdef DEBUG
     testGraph(graph);
 #endif
 
+    if (!options.socketPath.empty())
+    {
+        ServerOptions serverOptions;
+        serverOptions.socketPath = options.socketPath;
+        serverOptions.numWorkers = options.numWorkers;
+        serverOptions.idleTimeoutSeconds = options.idleTimeoutSeconds;
+        serverOptions.minNodes = options.minNodes;
+        serverOptions.maxNodes = options.maxNodes;
+        return QueryServer(graph, grid, serverOptions, scrapFolderPath).run();
+    }
+    if (!options.batchPath.empty())
+    {
+        return runBatch(graph, grid, options, scrapFolderPath, outputFilePath);
+    }
+
+    int startingNode = std::stoi(args[2]);
+    int endingNode = std::stoi(args[3]);
+
+    // Every search below indexes the graph by these nodes, so reject them before counting, estimating or enumerating
+    if (startingNode < 0 || startingNode >= graph.getNumNodes() || endingNode < 0 || endingNode >= graph.getNumNodes())
+    {
+        std::cout << "Node indices must be within the graph. Given: " << startingNode << ", " << endingNode << std::endl;
+        return 56;
+    }
+
     // Find all the possible paths given the graph's adjacency list
-    std::vector<std::vector<int>> validPaths = graph.findValidPaths(startingNode, endingNode);
+    // When pruning, the edges are costed up front so prefixes that cannot beat the cheapest path are cut
+    // Count the valid paths or find the k cheapest without materializing every valid path
+    if (options.countOnly)
+    {
+        double numPaths;
+        {
+            PhaseTimer timer(Phase::Enumeration);
+            numPaths = graph.countValidPaths(startingNode, endingNode, options.minNodes, options.maxNodes);
+        }
+
+        PhaseTimer timer(Phase::Output);
+        std::ofstream outputFile(outputFilePath);
+        outputFile << "Valid paths found: " << std::fixed << std::setprecision(0) << numPaths << std::endl;
+        outputFile.close();
+        return 0;
+    }
+    if (options.topK > 0)
+    {
+        outputLowestCostPaths(findCheapestPaths(graph, grid, startingNode, endingNode, options.topK, options.minNodes, options.maxNodes, scrapFolderPath), outputFilePath);
+        return 0;
+    }
+
+    // The number of paths grows exponentially with the node limits and the number of neighbors, so estimate it first
+    // and switch to pruning rather than enumerating and forking every path when it is over budget
+    double estimatedPaths = graph.estimateValidPathCount(startingNode, endingNode, options.minNodes, options.maxNodes);
+    if (!options.prune && estimatedPaths > options.pathBudget)
+    {
+        std::cout << "Warning: up to " << estimatedPaths << " valid paths estimated, over the budget of " << options.pathBudget
+                  << ". Switching to branch-and-bound path search." << std::endl;
+        options.prune = true;
+    }
+
+    std::vector<std::vector<int>> validPaths;
+    if (options.prune)
+    {
+        PhaseTimer timer(Phase::Enumeration);
+        PathBound bound = createSubpathCostBound(graph, grid, scrapFolderPath);
+        validPaths = graph.findValidPaths(startingNode, endingNode, bound, options.minNodes, options.maxNodes);
+        std::cout << "Pruned " << bound.prunedSubtrees << " subtrees during path enumeration." << std::endl;
+    }
+    else
+    {
+        PhaseTimer timer(Phase::Enumeration);
+        validPaths = graph.findValidPaths(startingNode, endingNode, options.minNodes, options.maxNodes);
+    }
+    countEvent(Counter::PathsEnumerated, validPaths.size());
 
     // Test the graph's paths by writing them to a file and then generate all the possible paths
     // (without the min and max nodes constraint) and write them to a file
@@ -81,9 +489,26 @@ int main(int argc, char **argv)
     outputAllGraphPaths(graph, startingNode, endingNode);
 #endif
 
-    // Find the cheapest path between given all the possible paths and output results to scrap folder
-    LowestCostPath bestPath = findCheapestPath(graph, grid, validPaths, startingNode, scrapFolderPath);
-    outputLowestCostPath(bestPath, outputFilePath);
+    // Find the cheapest path between given all the possible paths and output results to scrap folder,
+    // or search the subpaths on a pool of worker processes forked once instead of forking per path and subpath
+    try
+    {
+        if (options.numForkWorkers == 0)
+        {
+            LowestCostPath bestPath = findCheapestPath(graph, grid, validPaths, startingNode, scrapFolderPath, options.maxChildren);
+            outputLowestCostPath(bestPath, outputFilePath);
+            return 0;
+        }
+
+        std::unique_ptr<SubpathWorkerPool> pool = createSubpathWorkerPool(options.numForkWorkers, grid, scrapFolderPath);
+        LowestCostPath bestPath = findCheapestPath(graph, validPaths, startingNode, *pool);
+        outputLowestCostPath(bestPath, outputFilePath);
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 81;
+    }
 }
 
 #ifdef DEBUG
@@ -0,0 +1,460 @@
+#include "metrics.h"
+
+Metrics *metrics = nullptr;
+
+// The names of the phases and counters in the JSON report, in the order of their enums
+const char *const phaseNames[] = {"grid_load", "graph_build", "nearest_neighbors", "enumeration", "subpath_search", "cost_aggregation", "cost_patch", "output"};
+const char *const counterNames[] = {"paths_enumerated", "astar_expansions", "heap_pushes", "cache_hits", "cache_derived_hits",
+                                    "cache_disk_hits", "cache_misses", "forks", "scrap_bytes_written", "tile_hits", "tile_misses",
+                                    "tile_evictions"};
+
+const char *const hardwareEventNames[] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+
+static_assert(sizeof(phaseNames) / sizeof(phaseNames[0]) == static_cast<size_t>(Phase::Count), "Every phase needs a name");
+static_assert(sizeof(hardwareEventNames) / sizeof(hardwareEventNames[0]) == static_cast<size_t>(HardwareEvent::Count), "Every hardware event needs a name");
+static_assert(sizeof(counterNames) / sizeof(counterNames[0]) == static_cast<size_t>(Counter::Count), "Every counter needs a name");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Counters shared across processes must be lock free");
+
+// The process that enabled metrics and reports them at exit, and when it did
+pid_t metricsOwner = 0;
+std::chrono::steady_clock::time_point metricsStartTime;
+
+bool hardwareCountersEnabled = false;
+
+// Whether hardware counters were asked for, so the report can say they were unavailable
+bool hardwareCountersRequested = false;
+
+// The perf_event_open configuration of each hardware event, in the order of their enum
+const uint64_t hardwareEventConfigs[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+/**
+ * The hardware counters of a thread, opened as one group so they are read with one system call. A counter that cannot
+ * be opened is left out of the group.
+ */
+struct HardwareCounterGroup
+{
+    bool opened = false;
+    int leaderFd = -1;
+    int fds[static_cast<size_t>(HardwareEvent::Count)] = {-1, -1, -1, -1};
+    int slots[static_cast<size_t>(HardwareEvent::Count)] = {-1, -1, -1, -1}; // The position of each event in a group read
+    int numCounters = 0;
+
+    /**
+     * Closes the counters and marks them as not opened, so they are opened again on the next read.
+     */
+    void close()
+    {
+        for (int &fd : this->fds)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+            fd = -1;
+        }
+        std::fill(std::begin(this->slots), std::end(this->slots), -1);
+        this->leaderFd = -1;
+        this->numCounters = 0;
+        this->opened = false;
+    }
+
+    ~HardwareCounterGroup()
+    {
+        this->close();
+    }
+};
+
+thread_local HardwareCounterGroup hardwareCounterGroup;
+
+/**
+ * Opens the hardware counters of the calling thread. Only user space events of the thread itself are counted, which
+ * the default perf_event_paranoid setting allows.
+ *
+ * @param group The counters of the thread
+ * @return int The errno of opening the cycle counter that leads the group, or 0 if it opened
+ */
+int openHardwareCounters(HardwareCounterGroup &group)
+{
+    group.opened = true;
+    for (size_t event = 0; event < static_cast<size_t>(HardwareEvent::Count); event++)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = hardwareEventConfigs[event];
+        attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, group.leaderFd, PERF_FLAG_FD_CLOEXEC));
+        if (fd < 0)
+        {
+            if (group.leaderFd < 0)
+            {
+                return errno;
+            }
+            continue;
+        }
+
+        if (group.leaderFd < 0)
+        {
+            group.leaderFd = fd;
+        }
+        group.fds[event] = fd;
+        group.slots[event] = group.numCounters++;
+        metrics->countedHardwareEvents.fetch_or(1u << event, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+/**
+ * Counts hardware events (cycles, instructions, cache misses and branch misses) during every phase from now on, with
+ * perf_event_open counters opened per thread. Metrics must be enabled first. If the counters cannot be opened, for
+ * example in a container or with a strict perf_event_paranoid setting, a warning is printed and only times are
+ * reported.
+ *
+ * @return bool True if the counters were opened, false otherwise
+ */
+bool enableHardwareCounters()
+{
+    if (metrics == nullptr || hardwareCountersEnabled)
+    {
+        return hardwareCountersEnabled;
+    }
+    hardwareCountersRequested = true;
+
+    int error = openHardwareCounters(hardwareCounterGroup);
+    if (error != 0)
+    {
+        hardwareCounterGroup.close();
+        std::cerr << "Hardware counters are unavailable (" << std::strerror(error) << "). Only times are reported." << std::endl;
+        return false;
+    }
+
+    // The counters of a thread count only that thread, so a forked process opens its own on its first phase
+    pthread_atfork(nullptr, nullptr, []
+                   { hardwareCounterGroup.close(); });
+    hardwareCountersEnabled = true;
+    return true;
+}
+
+/**
+ * Reads the hardware event counts of the calling thread, opening its counters on its first read.
+ *
+ * @param values The array to store the count of each event in
+ * @return bool True if the counts were read, false if the counters of the thread are unavailable
+ */
+bool readHardwareEvents(uint64_t values[static_cast<size_t>(HardwareEvent::Count)])
+{
+    HardwareCounterGroup &group = hardwareCounterGroup;
+    if (!group.opened)
+    {
+        openHardwareCounters(group);
+    }
+    if (group.leaderFd < 0)
+    {
+        return false;
+    }
+
+    // The group is read as its size, the times it was enabled and running, then each count
+    uint64_t buffer[3 + static_cast<size_t>(HardwareEvent::Count)];
+    if (read(group.leaderFd, buffer, sizeof(buffer)) < static_cast<ssize_t>((3 + group.numCounters) * sizeof(uint64_t)))
+    {
+        return false;
+    }
+
+    // Scale the counts up if the counters were only running part of the time because the kernel multiplexed them
+    uint64_t timeEnabled = buffer[1], timeRunning = buffer[2];
+    for (size_t event = 0; event < static_cast<size_t>(HardwareEvent::Count); event++)
+    {
+        uint64_t count = group.slots[event] < 0 ? 0 : buffer[3 + group.slots[event]];
+        if (timeRunning > 0 && timeRunning < timeEnabled)
+        {
+            count = static_cast<uint64_t>(static_cast<double>(count) * timeEnabled / timeRunning);
+        }
+        values[event] = count;
+    }
+    return true;
+}
+
+/**
+ * Adds the hardware events counted since a phase started to the phase.
+ *
+ * @param phase The phase
+ * @param startValues The counts read when the phase started
+ */
+void recordHardwareEvents(Phase phase, const uint64_t startValues[static_cast<size_t>(HardwareEvent::Count)])
+{
+    uint64_t endValues[static_cast<size_t>(HardwareEvent::Count)];
+    if (!readHardwareEvents(endValues))
+    {
+        return;
+    }
+    for (size_t event = 0; event < static_cast<size_t>(HardwareEvent::Count); event++)
+    {
+        if (endValues[event] > startValues[event])
+        {
+            metrics->phaseHardwareEvents[static_cast<size_t>(phase)][event].fetch_add(endValues[event] - startValues[event], std::memory_order_relaxed);
+        }
+    }
+}
+
+#ifdef TRACK_ALLOCATIONS
+
+// The bytes allocated by operator new and not yet deleted in this process, and how deep the calling thread is in each phase
+std::atomic<uint64_t> liveHeapBytes{0};
+thread_local unsigned int allocationPhaseDepth[static_cast<size_t>(Phase::Count)] = {};
+
+/**
+ * Raises a shared maximum to a value if it is higher.
+ *
+ * @param maximum The maximum to raise
+ * @param value The value to raise it to
+ */
+void raiseMaximum(std::atomic<uint64_t> &maximum, uint64_t value)
+{
+    uint64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Adds an allocation to the live bytes of this process and, if metrics are enabled, to every phase the calling thread
+ * is inside. Sizes are taken from the allocator so allocations and deletions of the same block always match.
+ *
+ * @param block The allocated block, or nullptr if the allocation failed
+ */
+void recordAllocation(void *block)
+{
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    uint64_t size = malloc_usable_size(block);
+    uint64_t live = liveHeapBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    if (metrics == nullptr)
+    {
+        return;
+    }
+
+    raiseMaximum(metrics->peakHeapBytes, live);
+    bool phased = false;
+    for (size_t phase = 0; phase < static_cast<size_t>(Phase::Count); phase++)
+    {
+        if (allocationPhaseDepth[phase] > 0)
+        {
+            phased = true;
+            metrics->phaseAllocations[phase].fetch_add(1, std::memory_order_relaxed);
+            metrics->phaseAllocatedBytes[phase].fetch_add(size, std::memory_order_relaxed);
+            raiseMaximum(metrics->phasePeakHeapBytes[phase], live);
+        }
+    }
+    if (!phased)
+    {
+        metrics->unphasedAllocations.fetch_add(1, std::memory_order_relaxed);
+        metrics->unphasedAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Removes a deleted block from the live bytes of this process.
+ *
+ * @param block The block about to be freed, or nullptr
+ */
+void recordDeallocation(void *block)
+{
+    if (block != nullptr)
+    {
+        liveHeapBytes.fetch_sub(malloc_usable_size(block), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Get the resident high-water mark of this process.
+ *
+ * @return uint64_t The most bytes this process has had resident
+ */
+uint64_t peakResidentBytes()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+/**
+ * Marks the calling thread as inside a phase, so the allocations it makes are added to the phase. Phases can nest, and
+ * an allocation is added to every phase the thread is inside.
+ *
+ * @param phase The phase entered
+ */
+void enterAllocationPhase(Phase phase)
+{
+    allocationPhaseDepth[static_cast<size_t>(phase)]++;
+    raiseMaximum(metrics->phasePeakHeapBytes[static_cast<size_t>(phase)], liveHeapBytes.load(std::memory_order_relaxed));
+}
+
+/**
+ * Marks the calling thread as outside a phase it entered and records the resident high-water mark of the process.
+ *
+ * @param phase The phase left
+ */
+void leaveAllocationPhase(Phase phase)
+{
+    allocationPhaseDepth[static_cast<size_t>(phase)]--;
+    raiseMaximum(metrics->phasePeakResidentBytes[static_cast<size_t>(phase)], peakResidentBytes());
+}
+
+// Replace the global allocation functions. The array, sized and nothrow forms forward to these by default.
+void *operator new(size_t size)
+{
+    void *block = std::malloc(size == 0 ? 1 : size);
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    recordAllocation(block);
+    return block;
+}
+
+void operator delete(void *block) noexcept
+{
+    recordDeallocation(block);
+    std::free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    recordDeallocation(block);
+    std::free(block);
+}
+
+// Over-aligned types, such as the node arrays of the graph, are allocated through the aligned forms instead
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    // aligned_alloc needs a size that is a multiple of the alignment
+    size_t align = static_cast<size_t>(alignment);
+    void *block = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    recordAllocation(block);
+    return block;
+}
+
+void operator delete(void *block, std::align_val_t) noexcept
+{
+    recordDeallocation(block);
+    std::free(block);
+}
+
+void operator delete(void *block, size_t, std::align_val_t) noexcept
+{
+    recordDeallocation(block);
+    std::free(block);
+}
+
+#endif
+
+/**
+ * Get the name of a phase as it appears in the JSON report and the trace.
+ *
+ * @param phase The phase
+ * @return const char* The name of the phase
+ */
+const char *phaseName(Phase phase)
+{
+    return phaseNames[static_cast<size_t>(phase)];
+}
+
+/**
+ * Writes the JSON report to standard output, only from the process that enabled metrics since forked processes exit
+ * through the same handlers.
+ */
+void reportMetricsAtExit()
+{
+    if (getpid() == metricsOwner)
+    {
+        writeMetricsJson(std::cout);
+    }
+}
+
+/**
+ * Enables metrics for this process and the processes it forks from now on. A JSON report of every phase and counter
+ * is written to standard output when this process exits.
+ */
+void enableMetrics()
+{
+    if (metrics != nullptr)
+    {
+        return;
+    }
+
+    // An anonymous shared mapping stays shared with every process forked after it is created
+    void *region = mmap(nullptr, sizeof(Metrics), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED)
+    {
+        std::cerr << "Unable to allocate shared memory for metrics. Metrics are disabled." << std::endl;
+        return;
+    }
+    metrics = new (region) Metrics();
+
+    metricsOwner = getpid();
+    metricsStartTime = std::chrono::steady_clock::now();
+    std::atexit(reportMetricsAtExit);
+}
+
+/**
+ * Writes every phase and counter recorded so far as a JSON object.
+ *
+ * @param out The stream to write to
+ */
+void writeMetricsJson(std::ostream &out)
+{
+    if (metrics == nullptr)
+    {
+        out << "{}" << std::endl;
+        return;
+    }
+
+    std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - metricsStartTime;
+    out << "{\"wall_seconds\": " << wallTime.count() << ", \"phases\": {";
+    for (size_t phase = 0; phase < static_cast<size_t>(Phase::Count); phase++)
+    {
+        out << (phase == 0 ? "" : ", ") << "\"" << phaseNames[phase] << "\": {\"seconds\": "
+            << metrics->phaseNanoseconds[phase].load() / 1e9 << ", \"calls\": " << metrics->phaseCalls[phase].load();
+        for (size_t event = 0; event < static_cast<size_t>(HardwareEvent::Count); event++)
+        {
+            if (metrics->countedHardwareEvents.load() & (1u << event))
+            {
+                out << ", \"" << hardwareEventNames[event] << "\": " << metrics->phaseHardwareEvents[phase][event].load();
+            }
+        }
+#ifdef TRACK_ALLOCATIONS
+        out << ", \"allocations\": " << metrics->phaseAllocations[phase].load() << ", \"allocated_bytes\": " << metrics->phaseAllocatedBytes[phase].load()
+            << ", \"peak_heap_bytes\": " << metrics->phasePeakHeapBytes[phase].load() << ", \"peak_resident_bytes\": " << metrics->phasePeakResidentBytes[phase].load();
+#endif
+        out << "}";
+    }
+    out << "}, \"counters\": {";
+    for (size_t counter = 0; counter < static_cast<size_t>(Counter::Count); counter++)
+    {
+        out << (counter == 0 ? "" : ", ") << "\"" << counterNames[counter] << "\": " << metrics->counters[counter].load();
+    }
+    out << "}";
+    if (hardwareCountersRequested)
+    {
+        out << ", \"hardware_counters\": " << (hardwareCountersEnabled ? "\"available\"" : "\"unavailable\"");
+    }
+#ifdef TRACK_ALLOCATIONS
+    rusage children;
+    getrusage(RUSAGE_CHILDREN, &children);
+    out << ", \"memory\": {\"unphased_allocations\": " << metrics->unphasedAllocations.load() << ", \"unphased_allocated_bytes\": "
+        << metrics->unphasedAllocatedBytes.load() << ", \"peak_heap_bytes\": " << metrics->peakHeapBytes.load() << ", \"peak_resident_bytes\": "
+        << peakResidentBytes() << ", \"children_peak_resident_bytes\": " << static_cast<uint64_t>(children.ru_maxrss) * 1024 << "}";
+#endif
+    out << "}" << std::endl;
+}
@@ -0,0 +1,255 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <malloc.h>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "trace.h"
+
+/**
+ * The phases of a run that are timed. Phases can nest, for example subpath searches made while enumerating paths
+ * with pruning are timed in both.
+ */
+enum class Phase
+{
+    GridLoad,         // Reading the cost grid
+    GraphBuild,       // Reading the nodes and overlaying them on the grid
+    NearestNeighbors, // Connecting each node to its closest nodes
+    Enumeration,      // Enumerating, counting or ranking the valid paths
+    SubpathSearch,    // Finding the lowest cost subpath between two nodes, cached or not
+    CostAggregation,  // Joining the subpaths of a path and summing their costs
+    CostPatch,        // Applying a cost patch and bringing the cached subpaths up to date
+    Output,           // Writing the results
+    Count
+};
+
+/**
+ * The events of a run that are counted.
+ */
+enum class Counter
+{
+    PathsEnumerated,   // Valid paths enumerated or ranked
+    AStarExpansions,   // Cells taken off the priority queue of the A* or LPA* algorithm
+    HeapPushes,        // Cells pushed onto the priority queue of the A* or LPA* algorithm
+    CacheHits,         // Subpaths found in the in-memory cache
+    CacheDerivedHits,  // Subpaths derived from the cached subpath in the opposite direction
+    CacheDiskHits,     // Subpaths read from the persistent cache
+    CacheMisses,       // Subpaths searched for with the A* algorithm
+    Forks,             // Child and grandchild processes forked
+    ScrapBytesWritten, // Bytes written to the scrap files
+    TileHits,          // Tiles of a tiled grid found in the tile cache
+    TileMisses,        // Tiles of a tiled grid read from its file
+    TileEvictions,     // Tiles dropped from the tile cache to stay within its memory budget
+    Count
+};
+
+/**
+ * The hardware events counted per phase when hardware counters are enabled.
+ */
+enum class HardwareEvent
+{
+    Cycles,       // CPU cycles spent in user space
+    Instructions, // Instructions retired in user space
+    CacheMisses,  // Last level cache misses
+    BranchMisses, // Mispredicted branches
+    Count
+};
+
+/**
+ * The totals of every phase and counter, kept in memory shared by the processes forked after metrics are enabled so
+ * children and grandchildren add to the same totals as the parent.
+ */
+struct Metrics
+{
+    std::atomic<uint64_t> phaseNanoseconds[static_cast<size_t>(Phase::Count)];
+    std::atomic<uint64_t> phaseCalls[static_cast<size_t>(Phase::Count)];
+    std::atomic<uint64_t> counters[static_cast<size_t>(Counter::Count)];
+
+    // Hardware events counted during each phase, and a bit per event counted by any process
+    std::atomic<uint64_t> phaseHardwareEvents[static_cast<size_t>(Phase::Count)][static_cast<size_t>(HardwareEvent::Count)];
+    std::atomic<uint32_t> countedHardwareEvents;
+
+#ifdef TRACK_ALLOCATIONS
+    // Allocations made by the global operator new while each phase is active, in any process
+    std::atomic<uint64_t> phaseAllocations[static_cast<size_t>(Phase::Count)];
+    std::atomic<uint64_t> phaseAllocatedBytes[static_cast<size_t>(Phase::Count)];
+    std::atomic<uint64_t> phasePeakHeapBytes[static_cast<size_t>(Phase::Count)];     // The most bytes live in one process during the phase
+    std::atomic<uint64_t> phasePeakResidentBytes[static_cast<size_t>(Phase::Count)]; // The resident high-water mark of a process at the end of the phase
+    std::atomic<uint64_t> unphasedAllocations;
+    std::atomic<uint64_t> unphasedAllocatedBytes;
+    std::atomic<uint64_t> peakHeapBytes;
+#endif
+};
+
+/**
+ * The shared totals, or nullptr while metrics are disabled so every recording call reduces to a pointer check.
+ */
+extern Metrics *metrics;
+
+/**
+ * Enables metrics for this process and the processes it forks from now on. A JSON report of every phase and counter
+ * is written to standard output when this process exits.
+ */
+void enableMetrics();
+
+/**
+ * Whether the phases count hardware events. Only set once the counters were opened for this process.
+ */
+extern bool hardwareCountersEnabled;
+
+/**
+ * Counts hardware events (cycles, instructions, cache misses and branch misses) during every phase from now on, with
+ * perf_event_open counters opened per thread. Metrics must be enabled first. If the counters cannot be opened, for
+ * example in a container or with a strict perf_event_paranoid setting, a warning is printed and only times are
+ * reported.
+ *
+ * @return bool True if the counters were opened, false otherwise
+ */
+bool enableHardwareCounters();
+
+/**
+ * Reads the hardware event counts of the calling thread, opening its counters on its first read.
+ *
+ * @param values The array to store the count of each event in
+ * @return bool True if the counts were read, false if the counters of the thread are unavailable
+ */
+bool readHardwareEvents(uint64_t values[static_cast<size_t>(HardwareEvent::Count)]);
+
+/**
+ * Adds the hardware events counted since a phase started to the phase.
+ *
+ * @param phase The phase
+ * @param startValues The counts read when the phase started
+ */
+void recordHardwareEvents(Phase phase, const uint64_t startValues[static_cast<size_t>(HardwareEvent::Count)]);
+
+/**
+ * Writes every phase and counter recorded so far as a JSON object.
+ *
+ * @param out The stream to write to
+ */
+void writeMetricsJson(std::ostream &out);
+
+/**
+ * Get the name of a phase as it appears in the JSON report and the trace.
+ *
+ * @param phase The phase
+ * @return const char* The name of the phase
+ */
+const char *phaseName(Phase phase);
+
+#ifdef TRACK_ALLOCATIONS
+/**
+ * Marks the calling thread as inside a phase, so the allocations it makes are added to the phase. Phases can nest, and
+ * an allocation is added to every phase the thread is inside.
+ *
+ * @param phase The phase entered
+ */
+void enterAllocationPhase(Phase phase);
+
+/**
+ * Marks the calling thread as outside a phase it entered and records the resident high-water mark of the process.
+ *
+ * @param phase The phase left
+ */
+void leaveAllocationPhase(Phase phase);
+#endif
+
+/**
+ * Adds to an event counter if metrics are enabled.
+ *
+ * @param counter The counter to add to
+ * @param amount The number of events
+ */
+inline void countEvent(Counter counter, uint64_t amount = 1)
+{
+    if (metrics != nullptr)
+    {
+        metrics->counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Times the scope it lives in as one call of a phase if metrics are enabled, and records it as a span of the trace if
+ * tracing is enabled. The hardware events counted in the scope are added to the phase if hardware counters are enabled.
+ * When built with TRACK_ALLOCATIONS, the allocations made in the scope are added to the phase.
+ */
+class PhaseTimer
+{
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point startTime;
+    bool countingHardwareEvents = false;
+    uint64_t startHardwareEvents[static_cast<size_t>(HardwareEvent::Count)];
+#ifdef TRACK_ALLOCATIONS
+    bool trackingAllocations = false;
+#endif
+
+public:
+    explicit PhaseTimer(Phase phase) : phase(phase)
+    {
+#ifdef TRACK_ALLOCATIONS
+        if (metrics != nullptr)
+        {
+            this->trackingAllocations = true;
+            enterAllocationPhase(phase);
+        }
+#endif
+        if (metrics != nullptr || tracingEnabled)
+        {
+            this->startTime = std::chrono::steady_clock::now();
+        }
+        if (hardwareCountersEnabled)
+        {
+            this->countingHardwareEvents = readHardwareEvents(this->startHardwareEvents);
+        }
+    }
+
+    ~PhaseTimer()
+    {
+        if (this->countingHardwareEvents)
+        {
+            recordHardwareEvents(this->phase, this->startHardwareEvents);
+        }
+#ifdef TRACK_ALLOCATIONS
+        if (this->trackingAllocations)
+        {
+            leaveAllocationPhase(this->phase);
+        }
+#endif
+        if (metrics != nullptr || tracingEnabled)
+        {
+            std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+            if (metrics != nullptr)
+            {
+                std::chrono::nanoseconds elapsed = endTime - this->startTime;
+                metrics->phaseNanoseconds[static_cast<size_t>(this->phase)].fetch_add(elapsed.count(), std::memory_order_relaxed);
+                metrics->phaseCalls[static_cast<size_t>(this->phase)].fetch_add(1, std::memory_order_relaxed);
+            }
+            if (tracingEnabled)
+            {
+                recordTraceSpan(phaseName(this->phase), this->startTime, endTime);
+            }
+        }
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+};
+
+#endif // METRICS_H
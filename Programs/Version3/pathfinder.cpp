@@ -1,15 +1,66 @@
 #include "pathfinder.h"
 
 /**
- * Reads a grid from a file and constructs a matrix of floats representing the cost grid
+ * Reads a grid in the binary format: the magic bytes, the width and height as 32-bit unsigned integers and every cost
+ * as a 32-bit float, row by row.
  *
- * @param gridPath The path to the file containing the grid
+ * @param gridFile The grid file, positioned after the magic bytes
+ * @param gridPath The path to the file, for errors
  * @return std::vector<std::vector<float>> A matrix of floats representing the cost grid
  */
-std::vector<std::vector<float>> createCostGrid(std::string gridPath)
+std::vector<std::vector<float>> readBinaryCostGrid(std::ifstream &gridFile, const std::string &gridPath)
+{
+    uint32_t dimensions[2];
+    if (!gridFile.read(reinterpret_cast<char *>(dimensions), sizeof(dimensions)))
+    {
+        throw std::runtime_error("Error reading grid dimensions from file: " + gridPath);
+    }
+
+    uint32_t width = dimensions[0], height = dimensions[1];
+    if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX)
+    {
+        throw std::invalid_argument("Grid dimensions must be positive. Given: width=" + std::to_string(width) + ", height=" + std::to_string(height));
+    }
+
+    std::vector<std::vector<float>> grid = std::vector<std::vector<float>>(height, std::vector<float>(width));
+    for (uint32_t i = 0; i < height; i++)
+    {
+        if (!gridFile.read(reinterpret_cast<char *>(grid[i].data()), width * sizeof(float)))
+        {
+            throw std::runtime_error("Error reading row " + std::to_string(i) + " from file: " + gridPath);
+        }
+    }
+
+    return grid;
+}
+
+/**
+ * Reads a grid from a file and constructs a matrix of floats representing the cost grid. The file is either text, with
+ * the width and height on the first line and a line of costs per row, or in the binary format written by the grid
+ * generator. A file in the tiled grid format is opened instead of read, and its tiles are read as searches need them.
+ *
+ * @param gridPath The path to the file containing the grid
+ * @param tileCacheBytes The memory budget of the tile cache of a tiled grid
+ * @return CostGrid The cost grid, loaded into memory unless it is tiled
+ */
+CostGrid createCostGrid(std::string gridPath, size_t tileCacheBytes)
 {
+    PhaseTimer timer(Phase::GridLoad);
+
     // Open the file
-    std::ifstream gridFile(gridPath);
+    std::ifstream gridFile(gridPath, std::ios::binary);
+
+    char magic[sizeof(binaryGridMagic)] = {};
+    if (gridFile.read(magic, sizeof(magic)) && std::equal(magic, magic + sizeof(magic), binaryGridMagic))
+    {
+        return CostGrid(readBinaryCostGrid(gridFile, gridPath));
+    }
+    if (std::equal(magic, magic + sizeof(magic), tiledGridMagic))
+    {
+        return CostGrid(std::make_unique<TiledGrid>(gridPath, tileCacheBytes));
+    }
+    gridFile.clear();
+    gridFile.seekg(0);
 
     // Read the first line to get the dimensions of the grid
     std::string line;
@@ -45,7 +96,7 @@ std::vector<std::vector<float>> createCostGrid(std::string gridPath)
         }
     }
 
-    return grid;
+    return CostGrid(std::move(grid));
 }
 
 /**
@@ -57,17 +108,18 @@ std::vector<std::vector<float>> createCostGrid(std::string gridPath)
  * @param grid The cost grid to provide the bounds and weights for the graph
  * @return bool True if the graph is within the bounds of the cost grid, false otherwise
  */
-bool overlayGraph(Graph &graph, std::vector<std::vector<float>> &grid)
+bool overlayGraph(Graph &graph, CostGrid &grid)
 {
-    DEBUG_CONSOLE("Grid size " + std::to_string(grid.size()) + " " + std::to_string(grid[0].size()));
+    DEBUG_CONSOLE("Grid size " + std::to_string(grid.getNumRows()) + " " + std::to_string(grid.getNumCols()));
 
-    for (Node node : graph.getNodes())
+    for (int idx = 0; idx < graph.getNumNodes(); idx++)
     {
-        DEBUG_CONSOLE("Checking node: " + std::to_string(node.idx) + " at position: " + std::to_string(node.pos.first) + ", " + std::to_string(node.pos.second));
+        std::pair<int, int> pos = graph.getNodePosition(idx);
+        DEBUG_CONSOLE("Checking node: " + std::to_string(idx) + " at position: " + std::to_string(pos.first) + ", " + std::to_string(pos.second));
 
-        if (static_cast<size_t>(node.pos.first) >= grid.size() || static_cast<size_t>(node.pos.second) >= grid[0].size())
+        if (pos.first >= grid.getNumRows() || pos.second >= grid.getNumCols())
         {
-            throw std::invalid_argument("Node " + std::to_string(node.idx) + " is out of bounds.");
+            throw std::invalid_argument("Node " + std::to_string(idx) + " is out of bounds.");
             return false;
         }
     }
@@ -76,102 +128,336 @@ bool overlayGraph(Graph &graph, std::vector<std::vector<float>> &grid)
 
 /**
  * Cache to store the results of previously computed subpaths.
- * The key represents a pair of start and end positions.
+ * The key is the pair of start and end positions packed into 64 bits.
  * The value is a pair consisting of the cost of the subpath and the path itself.
- * The hash function is a custom hash function for pairs.
+ * The corridor of each subpath is indexed so the subpaths overlapping a region of the grid are found quickly.
  */
-std::unordered_map<std::pair<std::pair<int, int>, std::pair<int, int>>, std::pair<float, std::vector<std::pair<int, int>>>, PairHash> subpathCache;
+SubpathCache subpathCache(corridorPadding);
+
+/**
+ * Mutex guarding the subpath cache when queries are answered by several threads of the same process.
+ * Entries are only overwritten by applyCostPatch, which runs while no query holds a reference to them, so references
+ * to them stay valid without the lock.
+ */
+std::mutex subpathCacheMutex;
+
+/**
+ * How the subpaths requested from the subpath cache were found, guarded by the subpath cache mutex.
+ */
+SubpathCacheStats subpathCacheStats;
+
+/**
+ * Persistent subpath cache shared across runs on the same grid, if one was opened, and the path of its file.
+ */
+std::unique_ptr<DiskSubpathCache> diskSubpathCache;
+std::string diskSubpathCachePath;
+
+/**
+ * Whether the state of each subpath search is kept for incremental repair, set before any query is answered.
+ */
+bool retainSubpathSearches = false;
+
+/**
+ * The retained LPA* state of the subpaths searched since incremental repair was enabled, keyed like the subpath cache
+ * and guarded by the subpath cache mutex.
+ */
+std::unordered_map<SubpathKey, std::unique_ptr<IncrementalSubpathSearch>, SubpathKeyHash> subpathSearches;
+
+/**
+ * Opens a persistent subpath cache file that is consulted before searching for a subpath missing from the in-memory
+ * subpath cache. Entries are keyed by the grid's content hash and the corridor policy, so a cache file written for a
+ * different grid is invalidated.
+ *
+ * @param cachePath The path to the cache file
+ * @param grid The cost grid the subpaths are searched on
+ */
+void openDiskSubpathCache(const std::string &cachePath, const CostGrid &grid)
+{
+    diskSubpathCache = std::make_unique<DiskSubpathCache>(cachePath, hashGrid(grid), corridorPadding);
+    diskSubpathCachePath = cachePath;
+}
+
+/**
+ * Describes how a process ended from the status wait returned for it.
+ *
+ * @param status The status of the process
+ * @return std::string The exit status or the signal that killed the process
+ */
+static std::string describeExitStatus(int status)
+{
+    if (WIFSIGNALED(status))
+    {
+        return "was killed by signal " + std::to_string(WTERMSIG(status));
+    }
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+/**
+ * Checks whether a process ended successfully from the status wait returned for it.
+ *
+ * @param status The status of the process
+ * @return bool True if the process exited with status 0, false otherwise
+ */
+static bool exitedSuccessfully(int status)
+{
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
 
 /**
  * Find the cheapest path between the starting and destination node along the cost grid. First all valid paths of nodes is
- * found. Then for each valid path, fork a child process to output the nodes traversed to a scrap file. Each child process
+ * found. Then for each valid path, fork a child process to output the nodes traversed to the scrap file. Each child process
  * forks grandchild processes to compute the lowest cost subpath between each node pairing using Dijkstra's algorithm.
- * The cells of the grid traversed are written to scrap files. Finally, the cost of each path is computed and the lowest
- * cost path is outputed via the parent process.
+ * The cells of the grid traversed are written to the scrap file too, as records of a single ScrapStore that is unlinked
+ * once the cheapest path is found. Up to maxChildren children run at once and are reaped in the order they finish, and
+ * the cost of each finished path is computed while the others are still running. The lowest cost path is outputed via
+ * the parent process, the first of the cheapest paths if several cost the same.
+ *
+ * If a child or one of its grandchildren fails, no more children are forked, the running ones are waited for and the
+ * failure is thrown.
  *
  * @param graph The graph to search for the path
  * @param grid The cost grid to provide the bounds and weights for the graph
  * @param startingNode The index of the starting node
  * @param validPaths A vector of vectors containing the valid paths found
  * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @param maxChildren The most child processes running at once, or 0 for one per processor
  * @return LowestCostPath The information found for the lowest cost path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
  */
-LowestCostPath findCheapestPath(Graph &graph, std::vector<std::vector<float>> &grid, std::vector<std::vector<int>> validPaths, int startingNode, std::string scrapFolderPath)
+LowestCostPath findCheapestPath(Graph &graph, CostGrid &grid, std::vector<std::vector<int>> validPaths, int startingNode, std::string scrapFolderPath, unsigned int maxChildren)
 {
-    // Store the lowest cost path found
-    LowestCostPath bestPath = {std::vector<int>(), std::vector<std::pair<int, int>>(), std::numeric_limits<float>::max()};
+    // Store the lowest cost path found and the index of its valid path, to break ties by the order of the paths
+    LowestCostPath bestPath = {std::vector<int>(), CompactPath(), std::numeric_limits<float>::max()};
+    size_t bestPathIndex = validPaths.size();
 
-    // For each valid path, fork a child process to to explore each path and output the results to a scrap file
+    if (maxChildren == 0)
+    {
+        maxChildren = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // The nodes of path i are scrap record i and the subpaths of every path follow, in order
+    // The file is preallocated for subpaths that go straight to their ending node, which no subpath is shorter than
+    std::vector<size_t> firstSubpathRecords(validPaths.size());
+    size_t numRecords = validPaths.size(), preallocateBytes = 0;
     for (size_t i = 0; i < validPaths.size(); i++)
     {
-        pid_t pid = fork();
-        if (pid == 0)
+        firstSubpathRecords[i] = numRecords;
+        numRecords += validPaths[i].size() - 1;
+        preallocateBytes += validPaths[i].size() * sizeof(int32_t);
+        for (size_t j = 0; j + 1 < validPaths[i].size(); j++)
         {
-            std::string scrapFilePath = scrapFolderPath + "/child_" + std::to_string(i) + ".txt";
-            std::ofstream scrapFile(scrapFilePath);
+            std::pair<int, int> startPos = graph.getNodePosition(validPaths[i][j]), endPos = graph.getNodePosition(validPaths[i][j + 1]);
+            size_t minSteps = std::max(std::abs(startPos.first - endPos.first), std::abs(startPos.second - endPos.second));
+            preallocateBytes += sizeof(float) + sizeof(uint32_t) + CompactPath::packedSize(minSteps);
+        }
+    }
+    ScrapStore scrap(scrapFolderPath, numRecords, preallocateBytes);
 
-            for (int node : validPaths[i])
-            {
-                scrapFile << node << " ";
-            }
+    // The index of the valid path each running child explores, by process id
+    std::unordered_map<pid_t, size_t> runningChildren;
+    std::string failure;
 
-            scrapFile.close();
+    // Once a child has failed no more are forked, so only the running ones are left to wait for
+    size_t nextPath = 0;
+    while ((failure.empty() && nextPath < validPaths.size()) || !runningChildren.empty())
+    {
+        // Fork a child process for each valid path to explore it and output the results to a scrap file,
+        // keeping up to maxChildren running until one fails
+        while (failure.empty() && nextPath < validPaths.size() && runningChildren.size() < maxChildren)
+        {
+            size_t i = nextPath++;
 
-            // Now for each pair of nodes in the current path, fork a grandchild process to output the lowest cost subpath
-            // between the pair of nodes to a scrap file
-            for (size_t j = 0; j < validPaths[i].size() - 1; j++)
+            pid_t pid = fork();
+            if (pid == 0)
             {
-                pid_t grandchildPid = fork();
-                if (grandchildPid == 0)
+                setTraceProcessName("path " + std::to_string(i));
+                bool subpathsFailed = false;
                 {
-                    // Get the start and end node positions of the subpath
-                    Node startNode = graph.getNodes()[validPaths[i][j]];
-                    Node endNode = graph.getNodes()[validPaths[i][j + 1]];
-
-                    // Compute the positions traveled and the total cost for each pair of nodes
-                    findCheapestSubpath(startNode.pos, endNode.pos, grid, scrapFolderPath, i, j);
-                    exit(0);
-                }
-                else if (grandchildPid < 0)
-                {
-                    std::cerr << "Error forking grandchild process." << std::endl;
-                    exit(80);
+                    TraceScope childSpan("path " + std::to_string(i));
+
+                    std::vector<int32_t> nodes(validPaths[i].begin(), validPaths[i].end());
+                    scrap.write(i, nodes.data(), nodes.size() * sizeof(int32_t));
+
+                    // Now for each pair of nodes in the current path, fork a grandchild process to output the lowest cost subpath
+                    // between the pair of nodes to the scrap file
+                    std::unordered_map<pid_t, size_t> grandchildren;
+                    for (size_t j = 0; j < validPaths[i].size() - 1; j++)
+                    {
+                        pid_t grandchildPid = fork();
+                        if (grandchildPid == 0)
+                        {
+                            std::string subpathName = "subpath " + std::to_string(i) + "." + std::to_string(j);
+                            setTraceProcessName(subpathName);
+                            {
+                                TraceScope grandchildSpan(subpathName);
+
+                                // Compute the positions traveled and the total cost between the start and end nodes of the subpath
+                                findCheapestSubpath(graph.getNodePosition(validPaths[i][j]), graph.getNodePosition(validPaths[i][j + 1]), grid, scrapFolderPath, scrap, firstSubpathRecords[i] + j, i, j);
+                            }
+                            exit(0);
+                        }
+                        else if (grandchildPid < 0)
+                        {
+                            std::cerr << "Error forking grandchild process." << std::endl;
+                            exit(80);
+                        }
+                        countEvent(Counter::Forks);
+                        grandchildren[grandchildPid] = j;
+                    }
+
+                    // Wait for all grandchild processes to finish, reporting each that failed
+                    TraceScope waitSpan("wait for subpaths");
+                    int status = 0;
+                    pid_t grandchildPid;
+                    while ((grandchildPid = wait(&status)) > 0)
+                    {
+                        if (!exitedSuccessfully(status))
+                        {
+                            std::cerr << "Subpath " << i << "." << grandchildren[grandchildPid] << " " << describeExitStatus(status) << "." << std::endl;
+                            subpathsFailed = true;
+                        }
+                    }
                 }
+
+                // The spans of this process have ended, so they are written when it exits
+                exit(subpathsFailed ? 81 : 0);
+            }
+            else if (pid < 0)
+            {
+                std::cerr << "Error forking child process." << std::endl;
+                exit(80);
             }
+            countEvent(Counter::Forks);
+            runningChildren[pid] = i;
 
-            // Wait for all grandchild processes to finish
-            int status = 0;
-            while (wait(&status) > 0)
-                ;
+            DEBUG_CONSOLE("Child process " + std::to_string(i) + " forked.");
+        }
 
-            exit(0);
+        // Wait for whichever child finishes first
+        int status = 0;
+        pid_t pid;
+        {
+            TraceScope waitSpan("wait for paths");
+            pid = waitpid(-1, &status, 0);
         }
-        else if (pid < 0)
+        if (pid < 0)
         {
-            std::cerr << "Error forking child process." << std::endl;
-            exit(80);
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error(std::string("Error waiting for child processes: ") + std::strerror(errno));
         }
 
-        DEBUG_CONSOLE("Child process " + std::to_string(i) + " forked.");
+        auto child = runningChildren.find(pid);
+        if (child == runningChildren.end())
+        {
+            continue;
+        }
+        size_t i = child->second;
+        runningChildren.erase(child);
 
-        // Wait for all child processes to finish
-        int status = 0;
-        while (wait(&status) > 0)
-            ;
+        if (!exitedSuccessfully(status))
+        {
+            if (failure.empty())
+            {
+                failure = "Child process of path " + std::to_string(i) + " " + describeExitStatus(status) + ".";
+            }
+            continue;
+        }
+        if (!failure.empty())
+        {
+            continue;
+        }
 
         // Child has now finished, so the parent process will compute the cost of this path
-        LowestCostPath pathCost = computePathCost(scrapFolderPath, i, graph.getNodes()[startingNode].pos);
+        TraceScope pathSpan("path " + std::to_string(i));
+        LowestCostPath pathCost = computePathCost(scrap, i, firstSubpathRecords[i], graph.getNodePosition(startingNode));
 
-        // Update the lowest cost path if the current path has a lower cost
-        if (pathCost.cost < bestPath.cost)
+        // Update the lowest cost path if the current path has a lower cost, or the same cost and comes first
+        if (pathCost.cost < bestPath.cost || (pathCost.cost == bestPath.cost && i < bestPathIndex))
         {
             DEBUG_CONSOLE(std::to_string(pathCost.cost) + " is less than " + std::to_string(bestPath.cost) + ". Updating lowest cost.");
             bestPath = pathCost;
+            bestPathIndex = i;
+        }
+    }
+
+    // The scrap file is unlinked when the store goes out of scope, including when a failure is thrown
+    if (!failure.empty())
+    {
+        throw std::runtime_error(failure);
+    }
+
+    return bestPath;
+}
+
+/**
+ * Forks a pool of worker processes that search the subpaths sent to them with getCachedSubpath. The workers inherit
+ * the loaded grid and graph and the subpaths cached so far, so the pool is best created right before it is used.
+ *
+ * @param numWorkers The number of worker processes
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return std::unique_ptr<SubpathWorkerPool> The running pool
+ */
+std::unique_ptr<SubpathWorkerPool> createSubpathWorkerPool(size_t numWorkers, const CostGrid &grid, const std::string &scrapFolderPath)
+{
+    return std::make_unique<SubpathWorkerPool>(numWorkers, [&grid, scrapFolderPath](std::pair<int, int> startPos, std::pair<int, int> endPos)
+                                               { return getCachedSubpath(startPos, endPos, grid, scrapFolderPath, 0, 0); });
+}
+
+/**
+ * Find the cheapest path between the starting and destination node like findCheapestPath, but with the subpaths
+ * searched by a pool of worker processes forked once instead of a child process per path and a grandchild process per
+ * subpath. Each subpath shared by several valid paths is searched once, and the results come back through shared
+ * memory instead of scrap files. The cost of each path is summed in the same order as findCheapestPath sums it.
+ *
+ * @param graph The graph to search for the path
+ * @param validPaths A vector of vectors containing the valid paths found
+ * @param startingNode The index of the starting node
+ * @param pool The worker processes to search the subpaths on
+ * @return LowestCostPath The information found for the lowest cost path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
+ */
+LowestCostPath findCheapestPath(const Graph &graph, const std::vector<std::vector<int>> &validPaths, int startingNode, SubpathWorkerPool &pool)
+{
+    // Send every distinct subpath of the valid paths to the pool once
+    std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> subpaths;
+    std::unordered_map<SubpathKey, size_t, SubpathKeyHash> subpathIndices;
+    for (const std::vector<int> &nodePath : validPaths)
+    {
+        for (size_t j = 0; j + 1 < nodePath.size(); j++)
+        {
+            std::pair<int, int> startPos = graph.getNodePosition(nodePath[j]), endPos = graph.getNodePosition(nodePath[j + 1]);
+            if (subpathIndices.emplace(packSubpathKey(startPos, endPos), subpaths.size()).second)
+            {
+                subpaths.push_back({startPos, endPos});
+            }
         }
     }
+    std::vector<std::pair<float, CompactPath>> found = pool.searchSubpaths(subpaths);
+
+    PhaseTimer timer(Phase::CostAggregation);
+
+    // Store the lowest cost path found
+    LowestCostPath bestPath = {std::vector<int>(), CompactPath(), std::numeric_limits<float>::max()};
+    for (const std::vector<int> &nodePath : validPaths)
+    {
+        LowestCostPath pathCost = {nodePath, CompactPath(std::vector<std::pair<int, int>>{graph.getNodePosition(startingNode)}), 0};
+        for (size_t j = 0; j + 1 < nodePath.size(); j++)
+        {
+            const auto &[subpathCost, subpath] = found[subpathIndices.at(packSubpathKey(graph.getNodePosition(nodePath[j]), graph.getNodePosition(nodePath[j + 1])))];
 
-    // Remove all scrap files
-    // removeScrapFiles(scrapFolderPath);
+            // The first cell of each subpath is the last cell of the previous one, so only its steps are appended
+            pathCost.path.append(subpath);
+            pathCost.cost += subpathCost;
+        }
+
+        // Update the lowest cost path if the current path has a lower cost
+        if (pathCost.cost < bestPath.cost)
+        {
+            bestPath = pathCost;
+        }
+    }
 
     return bestPath;
 }
@@ -179,88 +465,568 @@ LowestCostPath findCheapestPath(Graph &graph, std::vector<std::vector<float>> &g
 /**
  * Given a one of the valid paths on the graph, fork a grandchild process for each node pairing in the path
  * and compute the lowest cost subpath between each node pairing using the A* algorithm. Uses memozation: if
- * the result is cached, it writes the cached result to the output file. Otherwise, it computes the path,
- * caches the result, and writes it to the file.
+ * the result is cached, it writes the cached result to the scrap file. Otherwise, it computes the path,
+ * caches the result, and writes it to the scrap file.
  *
  * @param startPos The starting position of the subpath
  * @param endPos The ending position of the subpath
  * @param grid The cost grid to provide the bounds and weights for the graph
  * @param scrapFolderPath The path to the folder where scrap files will be stored.
+ * @param scrap The scrap file the subpath is written to
+ * @param record The index of the scrap record of the subpath
  * @param pathIndex The index of the current path being processed.
  * @param subPathIndex The index of the current subpath (nodes in the path) being processed.
  */
-void findCheapestSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const std::vector<std::vector<float>> &grid, const std::string &scrapFolderPath, size_t pathIndex, size_t subPathIndex)
+void findCheapestSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const CostGrid &grid, const std::string &scrapFolderPath, ScrapStore &scrap, size_t record, size_t pathIndex, size_t subPathIndex)
 {
-    std::string grandchildFilePath = scrapFolderPath + "/grandchild_" + std::to_string(pathIndex) + "_" + std::to_string(subPathIndex) + ".txt";
-    std::ofstream grandchildFile(grandchildFilePath);
+    // The cost calculation includes the final node but not the starting node
+    const auto &[totalCost, path] = getCachedSubpath(startPos, endPos, grid, scrapFolderPath, pathIndex, subPathIndex);
+
+    // Only the steps are written, not the first position, since it's the starting position that the reader
+    // already has. If it were to be included, the starting and ending nodes would be duplicated.
+    // This has no effect on the cost calculation.
+    // The record is built whole so it is written with a single pwrite.
+    uint32_t numSteps = path.numSteps();
+    std::vector<char> bytes(sizeof(totalCost) + sizeof(numSteps) + path.packed().size());
+    std::memcpy(bytes.data(), &totalCost, sizeof(totalCost));
+    std::memcpy(bytes.data() + sizeof(totalCost), &numSteps, sizeof(numSteps));
+    std::memcpy(bytes.data() + sizeof(totalCost) + sizeof(numSteps), path.packed().data(), path.packed().size());
+    scrap.write(record, bytes.data(), bytes.size());
+}
 
-    // Compute the subgrid between the start and end positions
-    // The subgrid is formed by enclosing the start and end positions in a rectangle padded by 1
-    int startRow = std::max(std::min(startPos.first, endPos.first) - 1, 0);
-    int endRow = std::min(std::max(startPos.first, endPos.first) + 1, (int)grid.size() - 1);
-    int startCol = std::max(std::min(startPos.second, endPos.second) - 1, 0);
-    int endCol = std::min(std::max(startPos.second, endPos.second) + 1, (int)grid[0].size() - 1);
+/**
+ * Get how the subpaths requested so far in this process were found.
+ *
+ * @return SubpathCacheStats The counts of each way a subpath was found
+ */
+SubpathCacheStats getSubpathCacheStats()
+{
+    std::lock_guard<std::mutex> lock(subpathCacheMutex);
+    return subpathCacheStats;
+}
 
-    // The key is a pair of starting and ending positions
-    // The value is a pair consisting of the total cost of the path and a vector of pairs representing the path coordinates
-    std::pair<std::pair<int, int>, std::pair<int, int>> cacheKey = {startPos, endPos}; // Construct the cache key with startPos and endPos
+/**
+ * Writes how the subpaths requested so far in this process were found as one line.
+ *
+ * @param out The stream to write to
+ */
+void writeSubpathCacheStats(std::ostream &out)
+{
+    SubpathCacheStats stats = getSubpathCacheStats();
+    out << "Subpath cache: " << stats.hits << " hits, " << stats.derivedHits << " derived from the reverse subpath, "
+        << stats.diskHits << " read from disk, " << stats.searches << " searched." << std::endl;
+}
+
+/**
+ * Writes how the tiles of a tiled grid were found by this process and how much its tile cache holds as one line, or
+ * nothing if the grid is loaded into memory.
+ *
+ * @param grid The cost grid
+ * @param out The stream to write to
+ */
+void writeTileCacheStats(const CostGrid &grid, std::ostream &out)
+{
+    if (!grid.isTiled())
+    {
+        return;
+    }
+
+    TileCacheStats stats = grid.getTiles()->getStats();
+    out << "Tile cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evicted, "
+        << stats.residentTiles << " tiles resident (" << (stats.residentBytes >> 10) << " of " << (stats.budgetBytes >> 10) << " KB)." << std::endl;
+}
+
+/**
+ * Derives the lowest cost subpath in the opposite direction from a lowest cost subpath. The cells are reversed and
+ * the cost charges the ending position of the given subpath instead of its starting position.
+ *
+ * @param cost The cost of the subpath
+ * @param path The cells of the subpath
+ * @param grid The cost grid the subpath was searched on
+ * @return std::pair<float, CompactPath> The cost and cells of the reversed subpath
+ */
+std::pair<float, CompactPath> reverseSubpath(float cost, const CompactPath &path, const CostGrid &grid)
+{
+    std::pair<int, int> startPos = path.front();
+    std::pair<int, int> endPos = path.back();
+    return {cost - grid.cost(endPos.first, endPos.second) + grid.cost(startPos.first, startPos.second), path.reversed()};
+}
+
+/**
+ * Computes the corridor a subpath is searched within, the rectangle enclosing its start and end positions padded by
+ * corridorPadding and clipped to the grid. The corridor is the same in both directions.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param grid The cost grid providing the bounds
+ * @return CellRect The corridor of the subpath
+ */
+CellRect subpathCorridor(std::pair<int, int> startPos, std::pair<int, int> endPos, const CostGrid &grid)
+{
+    int startRow = std::max(std::min(startPos.first, endPos.first) - corridorPadding, 0);
+    int endRow = std::min(std::max(startPos.first, endPos.first) + corridorPadding, grid.getNumRows() - 1);
+    int startCol = std::max(std::min(startPos.second, endPos.second) - corridorPadding, 0);
+    int endCol = std::min(std::max(startPos.second, endPos.second) + corridorPadding, grid.getNumCols() - 1);
+    return CellRect{startRow, endRow, startCol, endCol};
+}
+
+/**
+ * Searches for the lowest cost subpath between two positions over its corridor, with LPA* when incremental repair is
+ * enabled so the search can be retained, and with the A* algorithm otherwise. The cost includes the ending position
+ * but not the starting position.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored.
+ * @param pathIndex The index of the current path being processed (used for debugging purposes).
+ * @param subPathIndex The index of the current subpath being processed (used for debugging purposes).
+ * @param search Set to the state of the LPA* search, or left empty when the A* algorithm was used
+ * @return std::pair<float, CompactPath> The cost and cells of the subpath
+ */
+std::pair<float, CompactPath> searchSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const CostGrid &grid, const std::string &scrapFolderPath, size_t pathIndex, size_t subPathIndex, std::unique_ptr<IncrementalSubpathSearch> &search)
+{
+    CellRect corridor = subpathCorridor(startPos, endPos, grid);
+
+    if (retainSubpathSearches)
+    {
+        search = std::make_unique<IncrementalSubpathSearch>(grid.getCells(), startPos, endPos, corridor.startRow, corridor.endRow, corridor.startCol, corridor.endCol);
+        search->computeShortestPath();
+        return {search->cost(), search->path()};
+    }
+
+    std::vector<std::pair<int, int>> cells;
+    float totalCost = aStar(grid, cells, startPos, endPos, corridor.startRow, corridor.endRow, corridor.startCol, corridor.endCol, scrapFolderPath, pathIndex, subPathIndex);
+    return {totalCost, CompactPath(cells)};
+}
+
+/**
+ * Looks up the lowest cost subpath between two positions in the subpath cache. On a miss, the persistent subpath
+ * cache is consulted if one was opened, and otherwise the subpath is computed with the A* algorithm over the padded
+ * rectangle enclosing both positions. The result is then cached.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored.
+ * @param pathIndex The index of the current path being processed (used for debugging purposes).
+ * @param subPathIndex The index of the current subpath being processed (used for debugging purposes).
+ * @return const std::pair<float, CompactPath>& The cached cost and cells of the subpath
+ */
+const std::pair<float, CompactPath> &getCachedSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const CostGrid &grid, const std::string &scrapFolderPath, size_t pathIndex, size_t subPathIndex)
+{
+    PhaseTimer timer(Phase::SubpathSearch);
 
     // Using mutex, lock the cache to avoid race conditions
-    std::mutex cacheMutex;
-    std::unique_lock<std::mutex> lock(cacheMutex);
+    std::unique_lock<std::mutex> lock(subpathCacheMutex);
 
     // Check if the result is already in the cache
-    auto iter = subpathCache.find(cacheKey);
-    if (iter != subpathCache.end())
+    const SubpathCache::Entry *cached = subpathCache.find(startPos, endPos);
+    if (cached != nullptr)
+    {
+        subpathCacheStats.hits++;
+        countEvent(Counter::CacheHits);
+        return *cached;
+    }
+
+    // Otherwise reuse the subpath in the opposite direction if it was already found
+    cached = subpathCache.find(endPos, startPos);
+    if (cached != nullptr)
+    {
+        subpathCacheStats.derivedHits++;
+        countEvent(Counter::CacheDerivedHits);
+        auto [reverseCost, reversePath] = reverseSubpath(cached->first, cached->second, grid);
+        return subpathCache.emplace(startPos, endPos, reverseCost, std::move(reversePath));
+    }
+
+    // Unlock the mutex while performing the A* algorithm to avoid holding the lock for too long
+    lock.unlock();
+
+    // Use the A* algorithm to find the lowest cost subpath between the start and end position
+    // unless an earlier run already stored it in either direction in the persistent cache
+    CompactPath path;
+    float totalCost;
+    bool derived = false, fromDisk = false;
+    std::unique_ptr<IncrementalSubpathSearch> search;
+    if (diskSubpathCache != nullptr && diskSubpathCache->lookup(startPos, endPos, totalCost, path))
     {
-        // Write the cached results to the output file
-        // Total cost
-        grandchildFile << iter->second.first << std::endl;
+        fromDisk = true;
+    }
+    else if (diskSubpathCache != nullptr && diskSubpathCache->lookup(endPos, startPos, totalCost, path))
+    {
+        std::tie(totalCost, path) = reverseSubpath(totalCost, path, grid);
+        derived = true;
+    }
+    else
+    {
+        std::tie(totalCost, path) = searchSubpath(startPos, endPos, grid, scrapFolderPath, pathIndex, subPathIndex, search);
 
-        // Path coordinates
-        for (size_t i = 1; i < iter->second.second.size(); ++i)
+        if (diskSubpathCache != nullptr)
         {
-            grandchildFile << iter->second.second[i].first << " " << iter->second.second[i].second << std::endl;
+            diskSubpathCache->append(startPos, endPos, totalCost, path);
         }
     }
-    else
+
+    // Lock the mutex again before updating the cache
+    lock.lock();
+    (derived ? subpathCacheStats.derivedHits : fromDisk ? subpathCacheStats.diskHits : subpathCacheStats.searches)++;
+    countEvent(derived ? Counter::CacheDerivedHits : fromDisk ? Counter::CacheDiskHits : Counter::CacheMisses);
+
+    // Store the result in the cache, keeping the entry of another thread that finished the same subpath first
+    // The search is only retained along with the entry it found
+    size_t numCached = subpathCache.size();
+    const SubpathCache::Entry &entry = subpathCache.emplace(startPos, endPos, totalCost, std::move(path));
+    if (search != nullptr && subpathCache.size() > numCached)
     {
-        // Unlock the mutex while performing the A* algorithm to avoid holding the lock for too long
-        lock.unlock();
+        subpathSearches[packSubpathKey(startPos, endPos)] = std::move(search);
+    }
+    return entry;
+}
 
-        // Use the A* algorithm to find the lowest cost subpath between the start and end position
-        std::vector<std::pair<int, int>> path;
+/**
+ * Keeps the state of every subpath search made from now on in this process, so the subpaths can be repaired
+ * incrementally when a cost patch changes cells in their corridor instead of being searched again. The subpaths are
+ * searched with LPA* instead of A*, which finds subpaths of the same cost but can break ties between them differently,
+ * and the state of each search holds two floats per cell of its corridor.
+ */
+void enableIncrementalSubpathRepair()
+{
+    retainSubpathSearches = true;
+}
 
-        // The cost calculation includes the final node but not the starting node
-        float totalCost = aStar(grid, path, startPos, endPos, startRow, endRow, startCol, endCol, scrapFolderPath, pathIndex, subPathIndex);
+/**
+ * Reads a cost patch file. The first line holds the number of changes and every following line holds the row, the
+ * column and the new cost of one cell, separated by spaces. A cell changed more than once takes its last cost.
+ *
+ * @param patchPath The path to the cost patch file
+ * @return std::vector<CellCostChange> The changes in the order they are listed
+ */
+std::vector<CellCostChange> readCostPatch(const std::string &patchPath)
+{
+    std::ifstream patchFile(patchPath);
+    if (!patchFile.is_open())
+    {
+        throw std::runtime_error("Cost patch file at specified path does not exist: " + patchPath);
+    }
 
-        // Lock the mutex again before updating the cache
-        lock.lock();
+    std::string line;
+    std::getline(patchFile, line);
+    std::istringstream iss(line);
+    size_t numChanges;
+    if (!(iss >> numChanges))
+    {
+        throw std::runtime_error("Error reading the number of changes from cost patch file: " + patchPath);
+    }
 
-        // Store the result in the cache
-        subpathCache[cacheKey] = {totalCost, path};
+    std::vector<CellCostChange> patch;
+    for (size_t i = 0; i < numChanges; i++)
+    {
+        if (!std::getline(patchFile, line))
+        {
+            throw std::runtime_error("Error reading line " + std::to_string(i + 2) + " from cost patch file: " + patchPath);
+        }
+        std::istringstream changeStream(line);
+        CellCostChange change;
+        if (!(changeStream >> change.row >> change.col >> change.cost))
+        {
+            throw std::runtime_error("Error reading change " + std::to_string(i) + " from cost patch file: " + patchPath);
+        }
+        patch.push_back(change);
+    }
+
+    return patch;
+}
+
+/**
+ * Applies a cost patch to the loaded cost grid and brings every cached subpath whose corridor holds a changed cell
+ * up to date, so the paths found afterwards are costed on the patched grid. A subpath with a retained search is
+ * repaired with LPA*, one whose reverse was brought up to date is derived from it again and any other is searched
+ * again. Cached subpaths whose corridor holds no changed cell keep their cost and cells. The persistent subpath cache,
+ * if one was opened, is reopened for the patched grid.
+ *
+ * No other thread may answer queries while the patch is applied, since they hold references to cached subpaths. A
+ * patch with a cell out of bounds or a negative cost is rejected before any cell is changed, and so is any patch to a
+ * tiled grid.
+ *
+ * @param grid The cost grid to patch
+ * @param patch The changes to apply
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return CostPatchStats The number of cells changed and how the affected subpaths were brought up to date
+ */
+CostPatchStats applyCostPatch(CostGrid &grid, const std::vector<CellCostChange> &patch, const std::string &scrapFolderPath)
+{
+    PhaseTimer timer(Phase::CostPatch);
+
+    if (grid.isTiled())
+    {
+        throw std::invalid_argument("Cost patches can only be applied to a grid loaded into memory.");
+    }
+
+    for (const CellCostChange &change : patch)
+    {
+        std::string cell = "(" + std::to_string(change.row) + ", " + std::to_string(change.col) + ")";
+        if (change.row < 0 || change.col < 0 || change.row >= grid.getNumRows() || change.col >= grid.getNumCols())
+        {
+            throw std::out_of_range("Cell " + cell + " of the cost patch is out of bounds.");
+        }
+        if (!(change.cost >= 0))
+        {
+            throw std::invalid_argument("Cell " + cell + " of the cost patch must have a non-negative cost.");
+        }
+    }
 
-        grandchildFile << totalCost << std::endl;
+    std::lock_guard<std::mutex> lock(subpathCacheMutex);
 
-        // Don't include the first position in the path (won't be written to the grandchild file) since it's the starting position
-        // If it were to be included, the starting and ending nodes would be duplicated.
-        // This has no effect on the cost calculation.
-        for (size_t i = 1; i < path.size(); ++i)
+    CostPatchStats stats;
+    std::vector<std::vector<float>> &cells = grid.getCells();
+    std::vector<std::pair<int, int>> changedCells;
+    for (const CellCostChange &change : patch)
+    {
+        if (cells[change.row][change.col] != change.cost)
         {
-            grandchildFile << path[i].first << " " << path[i].second << std::endl;
+            cells[change.row][change.col] = change.cost;
+            changedCells.push_back({change.row, change.col});
         }
+    }
+    std::sort(changedCells.begin(), changedCells.end());
+    changedCells.erase(std::unique(changedCells.begin(), changedCells.end()), changedCells.end());
+    stats.changedCells = changedCells.size();
+    if (changedCells.empty())
+    {
+        return stats;
+    }
 
-        grandchildFile.close();
+    // The subpaths stored for the old grid no longer apply
+    if (diskSubpathCache != nullptr)
+    {
+        diskSubpathCache.reset();
+        diskSubpathCache = std::make_unique<DiskSubpathCache>(diskSubpathCachePath, hashGrid(grid), corridorPadding);
     }
+
+    // Find the cached subpaths whose corridor holds a changed cell through the index of their corridors
+    std::vector<SubpathCache::Entry *> affected;
+    std::unordered_set<SubpathKey, SubpathKeyHash> affectedKeys;
+    auto collectAffected = [&affected, &affectedKeys](const SubpathKey &key, SubpathCache::Entry &entry)
+    {
+        if (affectedKeys.insert(key).second)
+        {
+            affected.push_back(&entry);
+        }
+    };
+    for (const std::pair<int, int> &cell : changedCells)
+    {
+        subpathCache.forEachOverlapping(CellRect{cell.first, cell.first, cell.second, cell.second}, collectAffected);
+    }
+
+    // Repair the subpaths with a retained search first, so their reverses can be derived from them
+    std::unordered_set<SubpathKey, SubpathKeyHash> updatedKeys;
+    for (SubpathCache::Entry *entry : affected)
+    {
+        SubpathKey key = packSubpathKey(entry->second.front(), entry->second.back());
+        auto searchIt = subpathSearches.find(key);
+        if (searchIt == subpathSearches.end())
+        {
+            continue;
+        }
+
+        IncrementalSubpathSearch &search = *searchIt->second;
+        for (const std::pair<int, int> &cell : changedCells)
+        {
+            search.notifyCostChanged(cell.first, cell.second);
+        }
+        search.computeShortestPath();
+        *entry = {search.cost(), search.path()};
+        updatedKeys.insert(key);
+        stats.repairedSubpaths++;
+    }
+
+    for (SubpathCache::Entry *entry : affected)
+    {
+        std::pair<int, int> startPos = entry->second.front();
+        std::pair<int, int> endPos = entry->second.back();
+        SubpathKey key = packSubpathKey(startPos, endPos);
+        if (updatedKeys.count(key) > 0)
+        {
+            continue;
+        }
+
+        if (updatedKeys.count(packSubpathKey(endPos, startPos)) > 0)
+        {
+            const SubpathCache::Entry *reverse = subpathCache.find(endPos, startPos);
+            *entry = reverseSubpath(reverse->first, reverse->second, grid);
+            stats.rederivedSubpaths++;
+        }
+        else
+        {
+            std::unique_ptr<IncrementalSubpathSearch> search;
+            *entry = searchSubpath(startPos, endPos, grid, scrapFolderPath, 0, 0, search);
+            if (search != nullptr)
+            {
+                subpathSearches[key] = std::move(search);
+            }
+            stats.recomputedSubpaths++;
+        }
+        updatedKeys.insert(key);
+    }
+
+    return stats;
+}
+
+/**
+ * Writes the counts of a cost patch as one line.
+ *
+ * @param stats The counts returned by applyCostPatch
+ * @param out The stream to write to
+ */
+void writeCostPatchStats(const CostPatchStats &stats, std::ostream &out)
+{
+    out << "Cost patch: " << stats.changedCells << " cells changed, " << stats.repairedSubpaths << " subpaths repaired, "
+        << stats.recomputedSubpaths << " searched again, " << stats.rederivedSubpaths << " derived from the reverse subpath." << std::endl;
+}
+
+/**
+ * Drops every cached subpath whose corridor overlaps a region of the grid, along with its retained search, so it is
+ * searched again the next time it is needed. Only the cached subpaths listed in the buckets of the region are visited.
+ *
+ * No other thread may answer queries while the subpaths are dropped, since they hold references to cached subpaths.
+ *
+ * @param region The region of the grid
+ * @return size_t The number of cached subpaths dropped
+ */
+size_t invalidateSubpaths(const CellRect &region)
+{
+    std::lock_guard<std::mutex> lock(subpathCacheMutex);
+    std::vector<SubpathKey> erasedKeys = subpathCache.invalidate(region);
+    for (const SubpathKey &key : erasedKeys)
+    {
+        subpathSearches.erase(key);
+    }
+    return erasedKeys.size();
+}
+
+/**
+ * Drops the cached subpaths of the edges a node update disconnected, in both directions, along with their retained
+ * searches.
+ *
+ * @param graph The updated graph
+ * @param update The edges added and removed by the update
+ * @return GraphUpdateStats The counts of the update
+ */
+GraphUpdateStats dropDisconnectedSubpaths(const Graph &graph, const NodeUpdate &update)
+{
+    GraphUpdateStats stats;
+    stats.node = update.node;
+    stats.addedEdges = update.addedEdges.size();
+    stats.removedEdges = update.removedEdges.size();
+
+    std::lock_guard<std::mutex> lock(subpathCacheMutex);
+    for (const auto &[a, b] : update.removedEdges)
+    {
+        std::pair<int, int> posA = graph.getNodePosition(a), posB = graph.getNodePosition(b);
+        for (const auto &[startPos, endPos] : {std::pair(posA, posB), std::pair(posB, posA)})
+        {
+            if (subpathCache.erase(startPos, endPos))
+            {
+                stats.droppedSubpaths++;
+            }
+            subpathSearches.erase(packSubpathKey(startPos, endPos));
+        }
+    }
+    return stats;
+}
+
+/**
+ * Adds a node to the graph and connects it by repairing only the closest nodes it changes. The cached subpaths of
+ * the edges the new node displaced are dropped along with their retained searches, and the other cached subpaths are
+ * kept.
+ *
+ * No other thread may answer queries while the node is added, since they read the graph and hold references to
+ * cached subpaths.
+ *
+ * @param graph The graph to add the node to
+ * @param grid The cost grid the node must lie in
+ * @param row The row of the new node
+ * @param col The column of the new node
+ * @return GraphUpdateStats The index of the new node and how the edges and cached subpaths changed
+ */
+GraphUpdateStats addGraphNode(Graph &graph, const CostGrid &grid, int row, int col)
+{
+    if (row < 0 || col < 0 || row >= grid.getNumRows() || col >= grid.getNumCols())
+    {
+        throw std::out_of_range("Node position " + std::to_string(row) + " " + std::to_string(col) + " is outside the grid.");
+    }
+
+    NodeUpdate update;
+    {
+        PhaseTimer timer(Phase::NearestNeighbors);
+        update = graph.addNode(row, col);
+    }
+    return dropDisconnectedSubpaths(graph, update);
+}
+
+/**
+ * Removes a node from the graph and reconnects only the nodes it was among the closest nodes of. The cached subpaths
+ * of its edges are dropped along with their retained searches, and the other cached subpaths are kept. The indices of
+ * the other nodes do not change.
+ *
+ * No other thread may answer queries while the node is removed, since they read the graph and hold references to
+ * cached subpaths.
+ *
+ * @param graph The graph to remove the node from
+ * @param node The index of the node to remove
+ * @return GraphUpdateStats The index of the removed node and how the edges and cached subpaths changed
+ */
+GraphUpdateStats removeGraphNode(Graph &graph, int node)
+{
+    NodeUpdate update;
+    {
+        PhaseTimer timer(Phase::NearestNeighbors);
+        update = graph.removeNode(node);
+    }
+    return dropDisconnectedSubpaths(graph, update);
+}
+
+/**
+ * Writes the counts of a node update as one line.
+ *
+ * @param stats The counts returned by addGraphNode or removeGraphNode
+ * @param added True if the node was added, false if it was removed
+ * @param out The stream to write to
+ */
+void writeGraphUpdateStats(const GraphUpdateStats &stats, bool added, std::ostream &out)
+{
+    out << "Node " << stats.node << (added ? " added: " : " removed: ") << stats.addedEdges << " edges added, " << stats.removedEdges
+        << " removed, " << stats.droppedSubpaths << " cached subpaths dropped." << std::endl;
+}
+
+/**
+ * Creates the branch-and-bound state for enumerating the valid paths where the cost of each edge is the exact
+ * cost of the lowest cost subpath between its nodes. The subpaths are computed in the calling process and
+ * kept in the subpath cache, so processes forked afterwards reuse them. The edge costs read the node positions from
+ * the graph, so it must outlive the state.
+ *
+ * @param graph The graph whose edges are costed
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return PathBound The branch-and-bound state with an exact edge cost oracle and no incumbent
+ */
+PathBound createSubpathCostBound(Graph &graph, const CostGrid &grid, const std::string &scrapFolderPath)
+{
+    PathBound bound;
+    bound.edgeCost = [&graph, &grid, scrapFolderPath](int from, int to)
+    {
+        return getCachedSubpath(graph.getNodePosition(from), graph.getNodePosition(to), grid, scrapFolderPath, from, to).first;
+    };
+    return bound;
 }
 
 /**
  * Implements the A* pathfinding algorithm to find the lowest cost path between two positions in a grid.
  * The algorithm uses a priority queue to visit cells in order of lowest cost and tracks the cost of the lowest
- * cost path to each cell. The path is reconstructed by backtracking from the end position to the start position.
- * Outputs debug information at each step.
+ * cost path to each cell of the subgrid. The path is reconstructed by backtracking from the end position to the start
+ * position. Outputs debug information at each step.
  *
- * @param grid A 2D vector representing the grid with costs for each cell.
+ * @param cellCost A function returning the cost of the cell at a row and column.
  * @param path A vector to store the resulting path as a sequence of (row, col) pairs.
  * @param startPos The starting position as a pair of (row, col).
  * @param endPos The ending position as a pair of (row, col).
@@ -273,14 +1039,16 @@ void findCheapestSubpath(std::pair<int, int> startPos, std::pair<int, int> endPo
  * @param subPathIndex The index of the subpath (used for debugging purposes).
  * @return The total cost of the lowest cost path found.
  */
-float aStar(const std::vector<std::vector<float>> &grid, std::vector<std::pair<int, int>> &path, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol, std::string scrapFolderPath, size_t pathIndex, size_t subPathIndex)
+template <typename CellCost>
+float aStarSearch(CellCost &&cellCost, std::vector<std::pair<int, int>> &path, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol, [[maybe_unused]] std::string scrapFolderPath, [[maybe_unused]] size_t pathIndex, [[maybe_unused]] size_t subPathIndex)
 {
-    // Debugging
+#ifdef DEBUG
     std::string debugFilePath = scrapFolderPath + "/debug_grandchild_" + std::to_string(pathIndex) + "_" + std::to_string(subPathIndex) + ".txt";
+#endif
 
-    DEBUG_FILE("Start Position: (" + std::to_string(startPos.first) + ", " + std::to_string(startPos.second) + ")", debugFilePath);
-    DEBUG_FILE("End Position: (" + std::to_string(endPos.first) + ", " + std::to_string(endPos.second) + ")", debugFilePath);
-    DEBUG_FILE("Subgrid bounds: (" + std::to_string(startRow) + ", " + std::to_string(startCol) + ") to (" + std::to_string(endRow) + ", " + std::to_string(endCol) + ")", debugFilePath);
+    DEBUG_FILE(DebugCategory::Search, "Start Position: (" + std::to_string(startPos.first) + ", " + std::to_string(startPos.second) + ")", debugFilePath);
+    DEBUG_FILE(DebugCategory::Search, "End Position: (" + std::to_string(endPos.first) + ", " + std::to_string(endPos.second) + ")", debugFilePath);
+    DEBUG_FILE(DebugCategory::Search, "Subgrid bounds: (" + std::to_string(startRow) + ", " + std::to_string(startCol) + ") to (" + std::to_string(endRow) + ", " + std::to_string(endCol) + ")", debugFilePath);
 
     // Implement Dijkstra's A* algorithm to find the lowest cost subpath between the start and end positions
     using Cell = std::pair<float, std::pair<int, int>>; // <cost, <row, col>>
@@ -289,40 +1057,52 @@ float aStar(const std::vector<std::vector<float>> &grid, std::vector<std::pair<i
     std::priority_queue<Cell, std::vector<Cell>, std::greater<Cell>> pq;
     pq.push({0, startPos});
 
-    DEBUG_FILE("Initialized priority queue with start position.", debugFilePath);
+    DEBUG_FILE(DebugCategory::Search, "Initialized priority queue with start position.", debugFilePath);
+
+    // The cells of the subgrid row by row, so the search holds memory for its subgrid only however large the grid is
+    int width = endCol - startCol + 1;
+    auto cellIndex = [startRow, startCol, width](int row, int col)
+    {
+        return (size_t)(row - startRow) * width + (col - startCol);
+    };
+    size_t numCells = (size_t)(endRow - startRow + 1) * width;
 
     // Initialize the cost matrix with maximum float values to represent infinity
     // This matrix will track the cost of the lowest cost path to each cell
-    std::vector<std::vector<float>> cost(grid.size(), std::vector<float>(grid[0].size(), std::numeric_limits<float>::max()));
+    std::vector<float> cost(numCells, std::numeric_limits<float>::max());
 
     // Initialize the predecessors matrix with pairs of (-1, -1)
     // This matrix will track the predecessor of each cell in the path
-    std::vector<std::vector<std::pair<int, int>>> predecessors(grid.size(), std::vector<std::pair<int, int>>(grid[0].size(), {-1, -1}));
+    std::vector<std::pair<int, int>> predecessors(numCells, {-1, -1});
 
     // Set the cost of the starting position to 0
-    cost[startPos.first][startPos.second] = 0;
+    cost[cellIndex(startPos.first, startPos.second)] = 0;
 
-    DEBUG_FILE("Initialized cost and predecessor matrices.", debugFilePath);
+    DEBUG_FILE(DebugCategory::Search, "Initialized cost and predecessor matrices.", debugFilePath);
 
     float totalCost = 0;
 
+    // Count locally and record once, so the loop is the same whether metrics are enabled or not
+    uint64_t numExpansions = 0, numPushes = 1;
+
     // Pathfinding loop
     while (!pq.empty())
     {
         // Get the cell with the lowest cost from the priority queue
         auto [currentCost, current] = pq.top();
         pq.pop();
+        numExpansions++;
 
         // Extract the row and column indices of the current cell
         int row = current.first, col = current.second;
 
-        DEBUG_FILE("Visiting cell: (" + std::to_string(row) + ", " + std::to_string(col) + ") with current cost: " + std::to_string(currentCost), debugFilePath);
+        DEBUG_FILE(DebugCategory::Search, "Visiting cell: (" + std::to_string(row) + ", " + std::to_string(col) + ") with current cost: " + std::to_string(currentCost), debugFilePath);
 
         // Check if we've reached the destination
         if (current == endPos)
         {
             totalCost = currentCost;
-            DEBUG_FILE("Reached end position with total cost: " + std::to_string(totalCost), debugFilePath);
+            DEBUG_FILE(DebugCategory::Search, "Reached end position with total cost: " + std::to_string(totalCost), debugFilePath);
             break;
         }
 
@@ -336,60 +1116,99 @@ float aStar(const std::vector<std::vector<float>> &grid, std::vector<std::pair<i
             if (newRow >= startRow && newRow <= endRow && newCol >= startCol && newCol <= endCol)
             {
                 // Compute the cost to move to the new cell
-                float newCost = currentCost + grid[newRow][newCol];
-                DEBUG_FILE("Checking cell: (" + std::to_string(newRow) + ", " + std::to_string(newCol) + ")", debugFilePath);
-                DEBUG_FILE("New cost = current cost + grid cost = " + std::to_string(currentCost) + " + " + std::to_string(grid[newRow][newCol]) + " = " + std::to_string(newCost), debugFilePath);
+                float newCost = currentCost + cellCost(newRow, newCol);
+                DEBUG_FILE(DebugCategory::Search, "Checking cell: (" + std::to_string(newRow) + ", " + std::to_string(newCol) + ")", debugFilePath);
+                DEBUG_FILE(DebugCategory::Search, "New cost = current cost + grid cost = " + std::to_string(currentCost) + " + " + std::to_string(cellCost(newRow, newCol)) + " = " + std::to_string(newCost), debugFilePath);
 
                 // Update the cost and predecessor if the new cost is lower
-                if (newCost < cost[newRow][newCol])
+                if (newCost < cost[cellIndex(newRow, newCol)])
                 {
-                    cost[newRow][newCol] = newCost;
-                    predecessors[newRow][newCol] = {row, col};
+                    cost[cellIndex(newRow, newCol)] = newCost;
+                    predecessors[cellIndex(newRow, newCol)] = {row, col};
                     pq.push({newCost, {newRow, newCol}});
+                    numPushes++;
 
-                    DEBUG_FILE("New cost is less than current cost. Updating cost and predecessor.", debugFilePath);
-                    DEBUG_FILE("Set predecessor of cell: (" + std::to_string(newRow) + ", " + std::to_string(newCol) + ") to: (" + std::to_string(row) + ", " + std::to_string(col) + ")", debugFilePath);
+                    DEBUG_FILE(DebugCategory::Search, "New cost is less than current cost. Updating cost and predecessor.", debugFilePath);
+                    DEBUG_FILE(DebugCategory::Search, "Set predecessor of cell: (" + std::to_string(newRow) + ", " + std::to_string(newCol) + ") to: (" + std::to_string(row) + ", " + std::to_string(col) + ")", debugFilePath);
                 }
             }
         }
     }
 
     // Reconstruct the path from the end position to the start position
-    for (std::pair<int, int> current = endPos; current != startPos; current = predecessors[current.first][current.second])
+    for (std::pair<int, int> current = endPos; current != startPos; current = predecessors[cellIndex(current.first, current.second)])
     {
         path.push_back(current);
     }
     path.push_back(startPos);
     std::reverse(path.begin(), path.end());
 
+    countEvent(Counter::AStarExpansions, numExpansions);
+    countEvent(Counter::HeapPushes, numPushes);
+
     return totalCost;
 }
 
+/**
+ * Implements the A* pathfinding algorithm to find the lowest cost path between two positions in a grid.
+ * The algorithm uses a priority queue to visit cells in order of lowest cost and tracks the cost of the lowest
+ * cost path to each cell of the subgrid. The path is reconstructed by backtracking from the end position to the start
+ * position. Outputs debug information at each step. The cells of a tiled grid are read through a tile cursor of the
+ * search.
+ *
+ * @param grid The cost grid with costs for each cell.
+ * @param path A vector to store the resulting path as a sequence of (row, col) pairs.
+ * @param startPos The starting position as a pair of (row, col).
+ * @param endPos The ending position as a pair of (row, col).
+ * @param startRow The starting row index of the subgrid to consider.
+ * @param endRow The ending row index of the subgrid to consider.
+ * @param startCol The starting column index of the subgrid to consider.
+ * @param endCol The ending column index of the subgrid to consider.
+ * @param scrapFolderPath The path to the folder where scrap files will be stored.
+ * @param pathIndex The index of the path (used for debugging purposes).
+ * @param subPathIndex The index of the subpath (used for debugging purposes).
+ * @return The total cost of the lowest cost path found.
+ */
+float aStar(const CostGrid &grid, std::vector<std::pair<int, int>> &path, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol, std::string scrapFolderPath, size_t pathIndex, size_t subPathIndex)
+{
+    if (TiledGrid *tiles = grid.getTiles())
+    {
+        TileCursor cursor(*tiles);
+        return aStarSearch([&cursor](int row, int col)
+                           { return cursor.cost(row, col); }, path, startPos, endPos, startRow, endRow, startCol, endCol, scrapFolderPath, pathIndex, subPathIndex);
+    }
+
+    const std::vector<std::vector<float>> &cells = grid.getCells();
+    return aStarSearch([&cells](int row, int col)
+                       { return cells[row][col]; }, path, startPos, endPos, startRow, endRow, startCol, endCol, scrapFolderPath, pathIndex, subPathIndex);
+}
+
 /**
  * Determine the lowest cost path's information by first going through the current child that represents a valid path of
- * nodes and then for each pair of nodes, read the grandchild file to find the positions on the cost grid it traveled and
- * sum the cost of each grandchild to finally determine which path was the cheapest.
+ * nodes and then for each pair of nodes, read the grandchild's record to find the positions on the cost grid it traveled
+ * and sum the cost of each grandchild to finally determine which path was the cheapest.
  *
- * @param scrapFolderPath The path to the folder where scrap files are stored.
- * @param pathIndex The index of the current path being processed.
- * @param startPos The starting position of the subpath due to not being included in the grandchild files.
+ * @param scrap The scrap file the child and grandchildren wrote their records to
+ * @param pathIndex The index of the current path being processed, which is also the index of its record of nodes
+ * @param firstSubpathRecord The index of the record of the first subpath of the path, followed by the rest in order
+ * @param startPos The starting position of the subpath due to not being included in the grandchild records.
  * @return LowestCostPath The information found for the lowest cost path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
  */
-LowestCostPath computePathCost(const std::string &scrapFolderPath, size_t pathIndex, std::pair<int, int> startPos)
+LowestCostPath computePathCost(ScrapStore &scrap, size_t pathIndex, size_t firstSubpathRecord, std::pair<int, int> startPos)
 {
-    // First open up the child file's that stores the nodes of the path to find out how many nodes are in the path
-    std::string scrapFilePath = scrapFolderPath + "/child_" + std::to_string(pathIndex) + ".txt";
-    std::vector<int> nodes = readChildPath(scrapFilePath);
+    PhaseTimer timer(Phase::CostAggregation);
+
+    // First read the child's record that stores the nodes of the path to find out how many nodes are in the path
+    std::vector<int> nodes = readChildPath(scrap, pathIndex);
 
     // Find the lowest cost path by summing the costs of the subpaths
     float totalCost = 0;
-    std::vector<std::pair<int, int>> path = {startPos}; // Include the starting position in the path
+    CompactPath path(std::vector<std::pair<int, int>>{startPos}); // Include the starting position in the path
 
-    // Then go through each child's grandchildren files that store the subpaths
+    // Then go through the records of each child's grandchildren that store the subpaths
     for (size_t subPathIndex = 0; subPathIndex < nodes.size() - 1; subPathIndex++)
     {
-        std::string grandchildFilePath = scrapFolderPath + "/grandchild_" + std::to_string(pathIndex) + "_" + std::to_string(subPathIndex) + ".txt";
-        totalCost += readGrandchildSubpath(grandchildFilePath, path);
+        totalCost += readGrandchildSubpath(scrap, firstSubpathRecord + subPathIndex, path);
     }
 
     DEBUG_CONSOLE("Total cost for path " + std::to_string(pathIndex) + ": " + std::to_string(totalCost));
@@ -398,64 +1217,64 @@ LowestCostPath computePathCost(const std::string &scrapFolderPath, size_t pathIn
 }
 
 /**
- * Reads a child file to get the nodes along the path
+ * Reads a child's record to get the nodes along the path
  *
- * @param filePath The path to the child file in the scrap folder
+ * @param scrap The scrap file the child wrote its record to
+ * @param record The index of the child's record
  * @return std::vector<int> The nodes along the path
  */
-std::vector<int> readChildPath(const std::string &filePath)
+std::vector<int> readChildPath(ScrapStore &scrap, size_t record)
 {
-    std::ifstream childFile(filePath);
+    size_t size = 0;
+    const char *bytes = scrap.read(record, size);
 
-    if (!childFile.is_open())
+    if (bytes == nullptr || size == 0 || size % sizeof(int32_t) != 0)
     {
-        std::cerr << "Error opening child scrap file: " << filePath << std::endl;
+        std::cerr << "Error reading child scrap record " << record << " from: " << scrap.getPath() << std::endl;
         exit(42);
     }
 
-    std::vector<int> nodes;
-    std::ifstream file(filePath);
-    int node;
-    while (file >> node)
-    {
-        nodes.push_back(node);
-    }
+    std::vector<int32_t> nodes(size / sizeof(int32_t));
+    std::memcpy(nodes.data(), bytes, size);
 
-    childFile.close();
-
-    return nodes;
+    return std::vector<int>(nodes.begin(), nodes.end());
 }
 
 /**
- * Reads a grandchild file to get the positions of the cells traversed in the subpath
+ * Reads a grandchild's record to get the cost of the subpath and the steps between the cells it traverses. The record
+ * holds the cost, the number of steps and the packed step codes of the subpath in binary.
  *
- * @param filePath The path to the grandchild file in the scrap folder
- * @return std::vector<std::pair<int, int>> The positions of the cells traversed in the subpath
+ * @param scrap The scrap file the grandchild wrote its record to
+ * @param record The index of the grandchild's record
+ * @param path The path ending at the first cell of the subpath, which the steps of the subpath are appended to
+ * @return float The cost of the subpath
  */
-float readGrandchildSubpath(const std::string &filePath, std::vector<std::pair<int, int>> &path)
+float readGrandchildSubpath(ScrapStore &scrap, size_t record, CompactPath &path)
 {
-    std::ifstream grandchildFile(filePath);
+    size_t size = 0;
+    const char *bytes = scrap.read(record, size);
 
-    if (!grandchildFile.is_open())
+    // Read in the total cost of the subpath and the number of steps it takes
+    float subPathCost;
+    uint32_t numSteps;
+    if (bytes == nullptr || size < sizeof(subPathCost) + sizeof(numSteps))
     {
-        std::cerr << "Error opening grandchild file: " << filePath << std::endl;
+        std::cerr << "Error reading grandchild scrap record " << record << " from: " << scrap.getPath() << std::endl;
         exit(43);
     }
-
-    // Read in the total cost of the subpath from the first line
-    float subPathCost;
-    grandchildFile >> subPathCost;
+    std::memcpy(&subPathCost, bytes, sizeof(subPathCost));
+    std::memcpy(&numSteps, bytes + sizeof(subPathCost), sizeof(numSteps));
 
     DEBUG_CONSOLE("Value: " + std::to_string(subPathCost));
 
-    // For every line after the first, read in the x and y positions of the cells traversed
-    int x, y;
-    while (grandchildFile >> x >> y)
+    // Then read in the packed codes of the steps and append them to the path
+    if (size != sizeof(subPathCost) + sizeof(numSteps) + CompactPath::packedSize(numSteps))
     {
-        path.emplace_back(x, y);
+        std::cerr << "Error reading grandchild scrap record " << record << " from: " << scrap.getPath() << std::endl;
+        exit(43);
     }
-
-    grandchildFile.close();
+    const uint8_t *packed = reinterpret_cast<const uint8_t *>(bytes + sizeof(subPathCost) + sizeof(numSteps));
+    path.append(CompactPath(path.front(), numSteps, packed));
 
     return subPathCost;
 }
@@ -471,30 +1290,177 @@ float readGrandchildSubpath(const std::string &filePath, std::vector<std::pair<i
  */
 void outputLowestCostPath(LowestCostPath bestPath, const std::string &outputFilePath)
 {
+    PhaseTimer timer(Phase::Output);
+
     std::ofstream outputFile(outputFilePath);
 
     outputFile << "Lowest cost path found:" << std::endl;
-    outputFile << "\t" << bestPath.nodes.size() << " nodes:";
-    for (int node : bestPath.nodes)
+    writeLowestCostPath(bestPath, outputFile);
+    outputFile.close();
+}
+
+/**
+ * Writes the nodes, grid points and total cost of a path in the format used by outputLowestCostPath.
+ *
+ * @param path The information found for the path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
+ * @param out The stream to write the path to
+ */
+void writeLowestCostPath(const LowestCostPath &path, std::ostream &out)
+{
+    out << "\t" << path.nodes.size() << " nodes:";
+    for (int node : path.nodes)
     {
-        outputFile << " " << node;
+        out << " " << node;
     }
-    outputFile << std::endl;
-    outputFile << "\t" << bestPath.path.size() << " grid points {row, col}:" << std::endl;
-    outputFile << "\t\t";
-    for (size_t i = 0; i < bestPath.path.size(); i++)
+    out << std::endl;
+    out << "\t" << path.path.size() << " grid points {row, col}:" << std::endl;
+    out << "\t\t";
+    size_t i = 0;
+    for (const std::pair<int, int> &cell : path.path)
     {
-        outputFile << "{" << bestPath.path[i].first << ", " << bestPath.path[i].second << "}";
-        if (i != bestPath.path.size() - 1)
+        out << "{" << cell.first << ", " << cell.second << "}";
+        if (++i != path.path.size())
         {
-            outputFile << ", ";
+            out << ", ";
         }
     }
-    outputFile << std::endl;
-    outputFile << "\tTotal cost: " << bestPath.cost << std::endl;
+    out << std::endl;
+    out << "\tTotal cost: " << path.cost << std::endl;
+}
+
+/**
+ * Output the k cheapest paths found, cheapest first, each in the same format as outputLowestCostPath.
+ *
+ * @param paths The information found for each path, cheapest first
+ * @param outputFilePath The path to the file where the results will be written
+ */
+void outputLowestCostPaths(const std::vector<LowestCostPath> &paths, const std::string &outputFilePath)
+{
+    PhaseTimer timer(Phase::Output);
+
+    std::ofstream outputFile(outputFilePath);
+
+    outputFile << paths.size() << " lowest cost paths found:" << std::endl;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        outputFile << "Path " << i + 1 << ":" << std::endl;
+        writeLowestCostPath(paths[i], outputFile);
+    }
     outputFile.close();
 }
 
+/**
+ * Find the k cheapest valid paths between the starting and destination node without enumerating every valid path.
+ * The edges are costed with cached subpaths and Yen's algorithm constrained to the node limits picks the paths.
+ *
+ * @param graph The graph to search for the paths
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param startingNode The index of the starting node
+ * @param endingNode The index of the ending node
+ * @param k The number of paths to find
+ * @param minNodes The minimum number of nodes a valid path must contain
+ * @param maxNodes The maximum number of nodes a valid path can contain
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return std::vector<LowestCostPath> Up to k paths, cheapest first
+ */
+std::vector<LowestCostPath> findCheapestPaths(Graph &graph, const CostGrid &grid, int startingNode, int endingNode, size_t k, unsigned int minNodes, unsigned int maxNodes, const std::string &scrapFolderPath)
+{
+    PathBound bound = createSubpathCostBound(graph, grid, scrapFolderPath);
+
+    std::vector<std::pair<float, std::vector<int>>> rankedPaths;
+    {
+        PhaseTimer timer(Phase::Enumeration);
+        rankedPaths = graph.findCheapestPaths(startingNode, endingNode, bound.edgeCost, k, minNodes, maxNodes);
+    }
+    countEvent(Counter::PathsEnumerated, rankedPaths.size());
+
+    std::vector<LowestCostPath> cheapestPaths;
+    for (const auto &[cost, nodePath] : rankedPaths)
+    {
+        cheapestPaths.push_back(joinCachedSubpaths(graph, nodePath, grid, scrapFolderPath));
+    }
+
+    if (cheapestPaths.size() == 0)
+    {
+        std::cout << "No valid paths found in the graph." << std::endl;
+    }
+
+    return cheapestPaths;
+}
+
+/**
+ * Joins the cached subpaths between consecutive nodes of a path into the cells traveled, the same way
+ * computePathCost joins the grandchild records, and sums their costs.
+ *
+ * @param graph The graph holding the positions of the nodes
+ * @param nodePath The indices of the nodes along the path
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return LowestCostPath The nodes in the path, the cost of the path, and the positions of the cells traveled in the path
+ */
+LowestCostPath joinCachedSubpaths(const Graph &graph, const std::vector<int> &nodePath, const CostGrid &grid, const std::string &scrapFolderPath)
+{
+    PhaseTimer timer(Phase::CostAggregation);
+
+    LowestCostPath joinedPath = {nodePath, CompactPath(std::vector<std::pair<int, int>>{graph.getNodePosition(nodePath[0])}), 0};
+    for (size_t i = 0; i + 1 < nodePath.size(); i++)
+    {
+        const auto &[subpathCost, subpath] = getCachedSubpath(graph.getNodePosition(nodePath[i]), graph.getNodePosition(nodePath[i + 1]), grid, scrapFolderPath, nodePath[i], nodePath[i + 1]);
+
+        // The first cell of each subpath is the last cell of the previous one, so only its steps are appended
+        joinedPath.path.append(subpath);
+        joinedPath.cost += subpathCost;
+    }
+    return joinedPath;
+}
+
+/**
+ * Answers a single lowest cost path query in the calling process without forking. The valid paths are enumerated
+ * with branch-and-bound over the cached subpath costs and the cheapest is joined from the cache, so every query
+ * answered by the same process shares the subpaths computed for earlier ones.
+ *
+ * @param graph The graph to search for the path
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param startingNode The index of the starting node
+ * @param endingNode The index of the ending node
+ * @param minNodes The minimum number of nodes a valid path must contain
+ * @param maxNodes The maximum number of nodes a valid path can contain
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return LowestCostPath The information found for the lowest cost path, with no nodes if there is no valid path
+ */
+LowestCostPath findLowestCostPath(Graph &graph, const CostGrid &grid, int startingNode, int endingNode, unsigned int minNodes, unsigned int maxNodes, const std::string &scrapFolderPath)
+{
+    if (startingNode < 0 || startingNode >= graph.getNumNodes() || endingNode < 0 || endingNode >= graph.getNumNodes())
+    {
+        throw std::out_of_range("Node indices must be within the graph. Given: " + std::to_string(startingNode) + ", " + std::to_string(endingNode));
+    }
+    if (graph.isRemoved(startingNode) || graph.isRemoved(endingNode))
+    {
+        throw std::out_of_range("Node " + std::to_string(graph.isRemoved(startingNode) ? startingNode : endingNode) + " was removed from the graph.");
+    }
+
+    PathBound bound = createSubpathCostBound(graph, grid, scrapFolderPath);
+    std::vector<std::vector<int>> validPaths;
+    {
+        PhaseTimer timer(Phase::Enumeration);
+        validPaths = graph.findValidPaths(startingNode, endingNode, bound, minNodes, maxNodes);
+    }
+    countEvent(Counter::PathsEnumerated, validPaths.size());
+
+    // Pick the first of the cheapest paths like findCheapestPath does
+    LowestCostPath bestPath = {std::vector<int>(), CompactPath(), std::numeric_limits<float>::max()};
+    for (const std::vector<int> &nodePath : validPaths)
+    {
+        LowestCostPath pathCost = joinCachedSubpaths(graph, nodePath, grid, scrapFolderPath);
+        if (pathCost.cost < bestPath.cost)
+        {
+            bestPath = pathCost;
+        }
+    }
+
+    return bestPath;
+}
+
 /**
  * Removes all files in the scrap folder
  *
@@ -13,20 +13,39 @@
 #include <limits>
 #include <filesystem>
 #include <mutex>
+#include <thread>
 #include <functional>
+#include <memory>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
 #include <unistd.h>
 #include <sys/wait.h>
 #include "graph.h"
+#include "gridformat.h"
+#include "costgrid.h"
+#include "tiledgrid.h"
+#include "compactpath.h"
+#include "diskcache.h"
+#include "subpathcache.h"
+#include "lpastar.h"
+#include "metrics.h"
+#include "trace.h"
+#include "workerpool.h"
+#include "scrapstore.h"
 #include "testing.h"
 
 /**
- * Reads a grid from a file and constructs a matrix of floats representing the cost grid
+ * Reads a grid from a file and constructs a matrix of floats representing the cost grid. The file is either text, with
+ * the width and height on the first line and a line of costs per row, or in the binary format written by the grid
+ * generator. A file in the tiled grid format is opened instead of read, and its tiles are read as searches need them.
  *
  * @param gridPath The path to the file containing the grid
- * @return std::vector<std::vector<float>> A matrix of floats representing the cost grid
+ * @param tileCacheBytes The memory budget of the tile cache of a tiled grid
+ * @return CostGrid The cost grid, loaded into memory unless it is tiled
  */
-std::vector<std::vector<float>> createCostGrid(std::string gridPath);
+CostGrid createCostGrid(std::string gridPath, size_t tileCacheBytes = defaultTileCacheBytes);
 
 /**
  * Throws an error if the graph is out of bounds based on the cost grid.
@@ -37,83 +56,295 @@ std::vector<std::vector<float>> createCostGrid(std::string gridPath);
  * @param grid The cost grid to provide the bounds and weights for the graph
  * @return bool True if the graph is within the bounds of the cost grid, false otherwise
  */
-bool overlayGraph(Graph &graph, std::vector<std::vector<float>> &grid);
+bool overlayGraph(Graph &graph, CostGrid &grid);
 
 /**
  * Struct to store the information found for the lowest cost path.
  */
 struct LowestCostPath
 {
-    std::vector<int> nodes;                // The nodes in the path
-    std::vector<std::pair<int, int>> path; // The positions of the cells traveled in the path
-    float cost;                            // The total cost of the path
+    std::vector<int> nodes; // The nodes in the path
+    CompactPath path;       // The positions of the cells traveled in the path
+    float cost;             // The total cost of the path
 };
 
 /**
  * Find the cheapest path between the starting and destination node along the cost grid. First all valid paths of nodes is
- * found. Then for each valid path, fork a child process to output the nodes traversed to a scrap file. Each child process
+ * found. Then for each valid path, fork a child process to output the nodes traversed to the scrap file. Each child process
  * forks grandchild processes to compute the lowest cost subpath between each node pairing using Dijkstra's algorithm.
- * The cells of the grid traversed are written to scrap files. Finally, the cost of each path is computed and the lowest
- * cost path is outputed via the parent process.
+ * The cells of the grid traversed are written to the scrap file too, as records of a single ScrapStore that is unlinked
+ * once the cheapest path is found. Up to maxChildren children run at once and are reaped in the order they finish, and
+ * the cost of each finished path is computed while the others are still running. The lowest cost path is outputed via
+ * the parent process, the first of the cheapest paths if several cost the same.
+ *
+ * If a child or one of its grandchildren fails, no more children are forked, the running ones are waited for and the
+ * failure is thrown.
  *
  * @param graph The graph to search for the path
  * @param grid The cost grid to provide the bounds and weights for the graph
  * @param startingNode The index of the starting node
  * @param validPaths A vector of vectors containing the valid paths found
  * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @param maxChildren The most child processes running at once, or 0 for one per processor
  * @return LowestCostPath The information found for the lowest cost path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
  */
-LowestCostPath findCheapestPath(Graph &graph, std::vector<std::vector<float>> &grid, std::vector<std::vector<int>> validPaths, int startingNode, std::string scrapFolderPath);
+LowestCostPath findCheapestPath(Graph &graph, CostGrid &grid, std::vector<std::vector<int>> validPaths, int startingNode, std::string scrapFolderPath, unsigned int maxChildren);
 
-/** Custom hash function for pairs to be used in the subpath cache
- * Combines the hash values of the two elements in the pair
- * 
- * Reference: https://ianyepan.github.io/posts/cpp-custom-hash/
+/**
+ * Forks a pool of worker processes that search the subpaths sent to them with getCachedSubpath. The workers inherit
+ * the loaded grid and graph and the subpaths cached so far, so the pool is best created right before it is used.
+ *
+ * @param numWorkers The number of worker processes
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return std::unique_ptr<SubpathWorkerPool> The running pool
  */
-struct PairHash
-{
-    template <typename T1, typename T2>
-    std::size_t operator()(const std::pair<T1, T2> &p) const
-    {
-        // Combine the hash values of the two elements in the pair
-        std::size_t h1 = std::hash<T1>{}(p.first);
-        std::size_t h2 = std::hash<T2>{}(p.second);
-        return h1 ^ (h2 << 1); // Bitwise combine with a shift
-    }
-
-    template <typename T1, typename T2, typename T3, typename T4>
-    std::size_t operator()(const std::pair<std::pair<T1, T2>, std::pair<T3, T4>> &p) const
-    {
-        // Hash the inner pairs individually and combine
-        std::size_t h1 = (*this)(p.first);
-        std::size_t h2 = (*this)(p.second);
-        return h1 ^ (h2 << 1); // Bitwise combine with a shift
-    }
-};
+std::unique_ptr<SubpathWorkerPool> createSubpathWorkerPool(size_t numWorkers, const CostGrid &grid, const std::string &scrapFolderPath);
+
+/**
+ * Find the cheapest path between the starting and destination node like findCheapestPath, but with the subpaths
+ * searched by a pool of worker processes forked once instead of a child process per path and a grandchild process per
+ * subpath. Each subpath shared by several valid paths is searched once, and the results come back through shared
+ * memory instead of scrap files. The cost of each path is summed in the same order as findCheapestPath sums it.
+ *
+ * @param graph The graph to search for the path
+ * @param validPaths A vector of vectors containing the valid paths found
+ * @param startingNode The index of the starting node
+ * @param pool The worker processes to search the subpaths on
+ * @return LowestCostPath The information found for the lowest cost path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
+ */
+LowestCostPath findCheapestPath(const Graph &graph, const std::vector<std::vector<int>> &validPaths, int startingNode, SubpathWorkerPool &pool);
 
 /**
  * Given a one of the valid paths on the graph, fork a grandchild process for each node pairing in the path
- * and compute the lowest cost subpath between each node pairing and write the results to a scrap file.
+ * and compute the lowest cost subpath between each node pairing using the A* algorithm. Uses memozation: if
+ * the result is cached, it writes the cached result to the scrap file. Otherwise, it computes the path,
+ * caches the result, and writes it to the scrap file.
  *
  * @param startPos The starting position of the subpath
  * @param endPos The ending position of the subpath
  * @param grid The cost grid to provide the bounds and weights for the graph
  * @param scrapFolderPath The path to the folder where scrap files will be stored.
+ * @param scrap The scrap file the subpath is written to
+ * @param record The index of the scrap record of the subpath
  * @param pathIndex The index of the current path being processed.
  * @param subPathIndex The index of the current subpath (nodes in the path) being processed.
  */
-void findCheapestSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const std::vector<std::vector<float>> &grid, const std::string &scrapFolderPath, size_t pathIndex, size_t subPathIndex);
+void findCheapestSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const CostGrid &grid, const std::string &scrapFolderPath, ScrapStore &scrap, size_t record, size_t pathIndex, size_t subPathIndex);
+
+// The number of cells the rectangle enclosing a subpath's start and end positions is padded by to form its search corridor
+const int corridorPadding = 1;
+
+/**
+ * Opens a persistent subpath cache file that is consulted before searching for a subpath missing from the in-memory
+ * subpath cache. Entries are keyed by the grid's content hash and the corridor policy, so a cache file written for a
+ * different grid is invalidated.
+ *
+ * @param cachePath The path to the cache file
+ * @param grid The cost grid the subpaths are searched on
+ */
+void openDiskSubpathCache(const std::string &cachePath, const CostGrid &grid);
 
-// Define direction vectors for moving in 8 possible directions on the cost grid
-const std::vector<std::pair<int, int>> directions = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+/**
+ * Counts of how the subpaths requested from the subpath cache of this process were found.
+ */
+struct SubpathCacheStats
+{
+    size_t hits = 0;        // Found in the in-memory cache
+    size_t derivedHits = 0; // Derived from the cached subpath in the opposite direction
+    size_t diskHits = 0;    // Read from the persistent cache
+    size_t searches = 0;    // Searched for with the A* algorithm
+};
+
+/**
+ * Get how the subpaths requested so far in this process were found.
+ *
+ * @return SubpathCacheStats The counts of each way a subpath was found
+ */
+SubpathCacheStats getSubpathCacheStats();
+
+/**
+ * Writes how the subpaths requested so far in this process were found as one line.
+ *
+ * @param out The stream to write to
+ */
+void writeSubpathCacheStats(std::ostream &out);
+
+/**
+ * Writes how the tiles of a tiled grid were found by this process and how much its tile cache holds as one line, or
+ * nothing if the grid is loaded into memory.
+ *
+ * @param grid The cost grid
+ * @param out The stream to write to
+ */
+void writeTileCacheStats(const CostGrid &grid, std::ostream &out);
+
+/**
+ * Looks up the lowest cost subpath between two positions in the subpath cache. On a miss, the subpath in the opposite
+ * direction is reused if it is cached, then the persistent subpath cache is consulted if one was opened, and otherwise
+ * the subpath is computed with the A* algorithm over the padded rectangle enclosing both positions. The result is then
+ * cached.
+ *
+ * The corridor of a subpath is the same in both directions and each cell entered is charged its cost, so the reverse
+ * of a lowest cost subpath is a lowest cost subpath in the opposite direction. Its cost only differs by charging the
+ * starting position instead of the ending position.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored.
+ * @param pathIndex The index of the current path being processed (used for debugging purposes).
+ * @param subPathIndex The index of the current subpath being processed (used for debugging purposes).
+ * @return const std::pair<float, CompactPath>& The cached cost and cells of the subpath
+ */
+const std::pair<float, CompactPath> &getCachedSubpath(std::pair<int, int> startPos, std::pair<int, int> endPos, const CostGrid &grid, const std::string &scrapFolderPath, size_t pathIndex, size_t subPathIndex);
+
+/**
+ * Keeps the state of every subpath search made from now on in this process, so the subpaths can be repaired
+ * incrementally when a cost patch changes cells in their corridor instead of being searched again. The subpaths are
+ * searched with LPA* instead of A*, which finds subpaths of the same cost but can break ties between them differently,
+ * and the state of each search holds two floats per cell of its corridor.
+ */
+void enableIncrementalSubpathRepair();
+
+/**
+ * A cell of the cost grid and the cost a cost patch sets it to.
+ */
+struct CellCostChange
+{
+    int row;
+    int col;
+    float cost;
+};
+
+/**
+ * Reads a cost patch file. The first line holds the number of changes and every following line holds the row, the
+ * column and the new cost of one cell, separated by spaces. A cell changed more than once takes its last cost.
+ *
+ * @param patchPath The path to the cost patch file
+ * @return std::vector<CellCostChange> The changes in the order they are listed
+ */
+std::vector<CellCostChange> readCostPatch(const std::string &patchPath);
+
+/**
+ * Counts of how the cached subpaths were brought up to date by a cost patch.
+ */
+struct CostPatchStats
+{
+    size_t changedCells = 0;       // Cells whose cost was changed
+    size_t repairedSubpaths = 0;   // Cached subpaths repaired from their retained LPA* state
+    size_t recomputedSubpaths = 0; // Cached subpaths searched again from scratch
+    size_t rederivedSubpaths = 0;  // Cached subpaths derived again from the updated subpath in the opposite direction
+};
+
+/**
+ * Applies a cost patch to the loaded cost grid and brings every cached subpath whose corridor holds a changed cell
+ * up to date, so the paths found afterwards are costed on the patched grid. A subpath with a retained search is
+ * repaired with LPA*, one whose reverse was brought up to date is derived from it again and any other is searched
+ * again. Cached subpaths whose corridor holds no changed cell keep their cost and cells. The persistent subpath cache,
+ * if one was opened, is reopened for the patched grid.
+ *
+ * No other thread may answer queries while the patch is applied, since they hold references to cached subpaths. A
+ * patch with a cell out of bounds or a negative cost is rejected before any cell is changed, and so is any patch to a
+ * tiled grid.
+ *
+ * @param grid The cost grid to patch
+ * @param patch The changes to apply
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return CostPatchStats The number of cells changed and how the affected subpaths were brought up to date
+ */
+CostPatchStats applyCostPatch(CostGrid &grid, const std::vector<CellCostChange> &patch, const std::string &scrapFolderPath);
+
+/**
+ * Writes the counts of a cost patch as one line.
+ *
+ * @param stats The counts returned by applyCostPatch
+ * @param out The stream to write to
+ */
+void writeCostPatchStats(const CostPatchStats &stats, std::ostream &out);
+
+/**
+ * Drops every cached subpath whose corridor overlaps a region of the grid, along with its retained search, so it is
+ * searched again the next time it is needed. Only the cached subpaths listed in the buckets of the region are visited.
+ *
+ * No other thread may answer queries while the subpaths are dropped, since they hold references to cached subpaths.
+ *
+ * @param region The region of the grid
+ * @return size_t The number of cached subpaths dropped
+ */
+size_t invalidateSubpaths(const CellRect &region);
+
+/**
+ * Counts of how the graph and the cached subpaths changed when a node was added or removed.
+ */
+struct GraphUpdateStats
+{
+    int node = -1;                // The index of the node added or removed
+    size_t addedEdges = 0;        // Edges connected by the update
+    size_t removedEdges = 0;      // Edges disconnected by the update
+    size_t droppedSubpaths = 0;   // Cached subpaths of the disconnected edges that were dropped
+};
+
+/**
+ * Adds a node to the graph and connects it by repairing only the closest nodes it changes. The cached subpaths of
+ * the edges the new node displaced are dropped along with their retained searches, and the other cached subpaths are
+ * kept.
+ *
+ * No other thread may answer queries while the node is added, since they read the graph and hold references to
+ * cached subpaths.
+ *
+ * @param graph The graph to add the node to
+ * @param grid The cost grid the node must lie in
+ * @param row The row of the new node
+ * @param col The column of the new node
+ * @return GraphUpdateStats The index of the new node and how the edges and cached subpaths changed
+ */
+GraphUpdateStats addGraphNode(Graph &graph, const CostGrid &grid, int row, int col);
+
+/**
+ * Removes a node from the graph and reconnects only the nodes it was among the closest nodes of. The cached subpaths
+ * of its edges are dropped along with their retained searches, and the other cached subpaths are kept. The indices of
+ * the other nodes do not change.
+ *
+ * No other thread may answer queries while the node is removed, since they read the graph and hold references to
+ * cached subpaths.
+ *
+ * @param graph The graph to remove the node from
+ * @param node The index of the node to remove
+ * @return GraphUpdateStats The index of the removed node and how the edges and cached subpaths changed
+ */
+GraphUpdateStats removeGraphNode(Graph &graph, int node);
+
+/**
+ * Writes the counts of a node update as one line.
+ *
+ * @param stats The counts returned by addGraphNode or removeGraphNode
+ * @param added True if the node was added, false if it was removed
+ * @param out The stream to write to
+ */
+void writeGraphUpdateStats(const GraphUpdateStats &stats, bool added, std::ostream &out);
+
+/**
+ * Creates the branch-and-bound state for enumerating the valid paths where the cost of each edge is the exact
+ * cost of the lowest cost subpath between its nodes. The subpaths are computed in the calling process and
+ * kept in the subpath cache, so processes forked afterwards reuse them. The edge costs read the node positions from
+ * the graph, so it must outlive the state.
+ *
+ * @param graph The graph whose edges are costed
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return PathBound The branch-and-bound state with an exact edge cost oracle and no incumbent
+ */
+PathBound createSubpathCostBound(Graph &graph, const CostGrid &grid, const std::string &scrapFolderPath);
 
 /**
  * Implements the A* pathfinding algorithm to find the lowest cost path between two positions in a grid.
  * The algorithm uses a priority queue to visit cells in order of lowest cost and tracks the cost of the lowest
- * cost path to each cell. The path is reconstructed by backtracking from the end position to the start position.
- * Outputs debug information at each step.
+ * cost path to each cell of the subgrid. The path is reconstructed by backtracking from the end position to the start
+ * position. Outputs debug information at each step. The cells of a tiled grid are read through a tile cursor of the
+ * search.
  *
- * @param grid A 2D vector representing the grid with costs for each cell.
+ * @param grid The cost grid with costs for each cell.
  * @param path A vector to store the resulting path as a sequence of (row, col) pairs.
  * @param startPos The starting position as a pair of (row, col).
  * @param endPos The ending position as a pair of (row, col).
@@ -126,35 +357,40 @@ const std::vector<std::pair<int, int>> directions = {{-1, -1}, {-1, 0}, {-1, 1},
  * @param subPathIndex The index of the subpath (used for debugging purposes).
  * @return The total cost of the lowest cost path found.
  */
-float aStar(const std::vector<std::vector<float>> &grid, std::vector<std::pair<int, int>> &path, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol, std::string scrapFolderPath, size_t pathIndex, size_t subPathIndex);
+float aStar(const CostGrid &grid, std::vector<std::pair<int, int>> &path, std::pair<int, int> startPos, std::pair<int, int> endPos, int startRow, int endRow, int startCol, int endCol, std::string scrapFolderPath, size_t pathIndex, size_t subPathIndex);
 
 /**
  * Determine the lowest cost path's information by first going through the current child that represents a valid path of
- * nodes and then for each pair of nodes, read the grandchild file to find the positions on the cost grid it traveled and
- * sum the cost of each grandchild to finally determine which path was the cheapest.
+ * nodes and then for each pair of nodes, read the grandchild's record to find the positions on the cost grid it traveled
+ * and sum the cost of each grandchild to finally determine which path was the cheapest.
  *
- * @param scrapFolderPath The path to the folder where scrap files are stored.
- * @param pathIndex The index of the current path being processed.
- * @param startPos The starting position of the subpath due to not being included in the grandchild files.
+ * @param scrap The scrap file the child and grandchildren wrote their records to
+ * @param pathIndex The index of the current path being processed, which is also the index of its record of nodes
+ * @param firstSubpathRecord The index of the record of the first subpath of the path, followed by the rest in order
+ * @param startPos The starting position of the subpath due to not being included in the grandchild records.
  * @return LowestCostPath The information found for the lowest cost path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
  */
-LowestCostPath computePathCost(const std::string &scrapFolderPath, size_t pathIndex, std::pair<int, int> startPos);
+LowestCostPath computePathCost(ScrapStore &scrap, size_t pathIndex, size_t firstSubpathRecord, std::pair<int, int> startPos);
 
 /**
- * Reads a child file to get the nodes along the path
+ * Reads a child's record to get the nodes along the path
  *
- * @param filePath The path to the child file in the scrap folder
+ * @param scrap The scrap file the child wrote its record to
+ * @param record The index of the child's record
  * @return std::vector<int> The nodes along the path
  */
-std::vector<int> readChildPath(const std::string &filePath);
+std::vector<int> readChildPath(ScrapStore &scrap, size_t record);
 
 /**
- * Reads a grandchild file to get the positions of the cells traversed in the subpath
+ * Reads a grandchild's record to get the cost of the subpath and the steps between the cells it traverses. The record
+ * holds the cost, the number of steps and the packed step codes of the subpath in binary.
  *
- * @param filePath The path to the grandchild file in the scrap folder
- * @return std::vector<std::pair<int, int>> The positions of the cells traversed in the subpath
+ * @param scrap The scrap file the grandchild wrote its record to
+ * @param record The index of the grandchild's record
+ * @param path The path ending at the first cell of the subpath, which the steps of the subpath are appended to
+ * @return float The cost of the subpath
  */
-float readGrandchildSubpath(const std::string &filePath, std::vector<std::pair<int, int>> &path);
+float readGrandchildSubpath(ScrapStore &scrap, size_t record, CompactPath &path);
 
 /**
  * Output the final results of the best path found, which includes
@@ -167,6 +403,66 @@ float readGrandchildSubpath(const std::string &filePath, std::vector<std::pair<i
  */
 void outputLowestCostPath(LowestCostPath bestPath, const std::string &outputFilePath);
 
+/**
+ * Writes the nodes, grid points and total cost of a path in the format used by outputLowestCostPath.
+ *
+ * @param path The information found for the path, including the nodes in the path, the cost of the path, and the positions of the cells traveled in the path
+ * @param out The stream to write the path to
+ */
+void writeLowestCostPath(const LowestCostPath &path, std::ostream &out);
+
+/**
+ * Output the k cheapest paths found, cheapest first, each in the same format as outputLowestCostPath.
+ *
+ * @param paths The information found for each path, cheapest first
+ * @param outputFilePath The path to the file where the results will be written
+ */
+void outputLowestCostPaths(const std::vector<LowestCostPath> &paths, const std::string &outputFilePath);
+
+/**
+ * Find the k cheapest valid paths between the starting and destination node without enumerating every valid path.
+ * The edges are costed with cached subpaths and Yen's algorithm constrained to the node limits picks the paths.
+ *
+ * @param graph The graph to search for the paths
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param startingNode The index of the starting node
+ * @param endingNode The index of the ending node
+ * @param k The number of paths to find
+ * @param minNodes The minimum number of nodes a valid path must contain
+ * @param maxNodes The maximum number of nodes a valid path can contain
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return std::vector<LowestCostPath> Up to k paths, cheapest first
+ */
+std::vector<LowestCostPath> findCheapestPaths(Graph &graph, const CostGrid &grid, int startingNode, int endingNode, size_t k, unsigned int minNodes, unsigned int maxNodes, const std::string &scrapFolderPath);
+
+/**
+ * Joins the cached subpaths between consecutive nodes of a path into the cells traveled, the same way
+ * computePathCost joins the grandchild records, and sums their costs.
+ *
+ * @param graph The graph holding the positions of the nodes
+ * @param nodePath The indices of the nodes along the path
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return LowestCostPath The nodes in the path, the cost of the path, and the positions of the cells traveled in the path
+ */
+LowestCostPath joinCachedSubpaths(const Graph &graph, const std::vector<int> &nodePath, const CostGrid &grid, const std::string &scrapFolderPath);
+
+/**
+ * Answers a single lowest cost path query in the calling process without forking. The valid paths are enumerated
+ * with branch-and-bound over the cached subpath costs and the cheapest is joined from the cache, so every query
+ * answered by the same process shares the subpaths computed for earlier ones.
+ *
+ * @param graph The graph to search for the path
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param startingNode The index of the starting node
+ * @param endingNode The index of the ending node
+ * @param minNodes The minimum number of nodes a valid path must contain
+ * @param maxNodes The maximum number of nodes a valid path can contain
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ * @return LowestCostPath The information found for the lowest cost path, with no nodes if there is no valid path
+ */
+LowestCostPath findLowestCostPath(Graph &graph, const CostGrid &grid, int startingNode, int endingNode, unsigned int minNodes, unsigned int maxNodes, const std::string &scrapFolderPath);
+
 /**
  * Removes all files in the scrap folder
  *
@@ -0,0 +1,135 @@
+#include "scrapstore.h"
+
+/**
+ * Creates the scrap file in the scrap folder and the shared index of its records.
+ *
+ * @param scrapFolderPath The path to the folder where the scrap file will be stored
+ * @param numRecords The number of records that can be written
+ * @param preallocateBytes The size the file is preallocated to, which it can grow past
+ */
+ScrapStore::ScrapStore(const std::string &scrapFolderPath, size_t numRecords, size_t preallocateBytes)
+    : scrapPath(scrapFolderPath + "/scrap_" + std::to_string(getpid()) + ".bin"), owner(getpid()), numRecords(numRecords)
+{
+    this->fd = open(this->scrapPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (this->fd < 0)
+    {
+        throw std::runtime_error("Error opening scrap file: " + this->scrapPath + ": " + std::strerror(errno));
+    }
+
+    // Reserve the blocks up front so appending records does not grow the file a block at a time
+    // Some filesystems cannot preallocate, and the file then grows as records are written
+    if (preallocateBytes > 0)
+    {
+        posix_fallocate(this->fd, 0, preallocateBytes);
+    }
+
+    // An anonymous shared mapping stays shared with every process forked after it is created
+    this->sharedBytes = sizeof(SharedIndex) + numRecords * sizeof(IndexEntry);
+    this->shared = mmap(nullptr, this->sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (this->shared == MAP_FAILED)
+    {
+        close(this->fd);
+        unlink(this->scrapPath.c_str());
+        throw std::runtime_error(std::string("Unable to allocate shared memory for the scrap index: ") + std::strerror(errno));
+    }
+    this->sharedIndex = new (this->shared) SharedIndex();
+    this->entries = reinterpret_cast<IndexEntry *>(this->sharedIndex + 1);
+}
+
+/**
+ * Unmaps the file and the index. The process that created the store also closes and unlinks the file.
+ */
+ScrapStore::~ScrapStore()
+{
+    if (this->mapping != nullptr)
+    {
+        munmap(const_cast<char *>(this->mapping), this->mappedSize);
+    }
+    munmap(this->shared, this->sharedBytes);
+    close(this->fd);
+
+    if (getpid() == this->owner)
+    {
+        unlink(this->scrapPath.c_str());
+    }
+}
+
+/**
+ * Writes a record at the end of the file. Each record is written once, by any process forked after the store was
+ * created.
+ *
+ * @param record The index of the record
+ * @param data The bytes of the record
+ * @param size The number of bytes of the record
+ */
+void ScrapStore::write(size_t record, const void *data, size_t size)
+{
+    if (record >= this->numRecords)
+    {
+        throw std::out_of_range("Scrap record " + std::to_string(record) + " is outside the " + std::to_string(this->numRecords) + " records of the store.");
+    }
+
+    uint64_t offset = this->sharedIndex->reservedBytes.fetch_add(size);
+
+    // pwrite may write fewer bytes than asked for, so write until the record is complete
+    const char *bytes = static_cast<const char *>(data);
+    for (size_t done = 0; done < size;)
+    {
+        ssize_t numWritten = pwrite(this->fd, bytes + done, size - done, offset + done);
+        if (numWritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numWritten <= 0)
+        {
+            throw std::runtime_error("Error writing to scrap file: " + this->scrapPath + ": " + std::strerror(errno));
+        }
+        done += numWritten;
+    }
+
+    // The reader only looks at the entry once this process has exited, which orders it after the write
+    this->entries[record] = {offset, size, true};
+    countEvent(Counter::ScrapBytesWritten, size);
+}
+
+/**
+ * Get the bytes of a record written by this process or by a process that has since exited.
+ *
+ * @param record The index of the record
+ * @param size Set to the number of bytes of the record
+ * @return const char* The bytes of the record, valid until the next read, or nullptr if it was never written
+ */
+const char *ScrapStore::read(size_t record, size_t &size)
+{
+    if (record >= this->numRecords || !this->entries[record].written)
+    {
+        return nullptr;
+    }
+    const IndexEntry &entry = this->entries[record];
+
+    // Map the file again once records have been written past the end of the mapping
+    if (entry.offset + entry.size > this->mappedSize)
+    {
+        struct stat st;
+        if (fstat(this->fd, &st) != 0 || static_cast<size_t>(st.st_size) < entry.offset + entry.size)
+        {
+            return nullptr;
+        }
+        if (this->mapping != nullptr)
+        {
+            munmap(const_cast<char *>(this->mapping), this->mappedSize);
+            this->mapping = nullptr;
+            this->mappedSize = 0;
+        }
+        void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        this->mapping = static_cast<const char *>(mapped);
+        this->mappedSize = st.st_size;
+    }
+
+    size = entry.size;
+    return this->mapping + entry.offset;
+}
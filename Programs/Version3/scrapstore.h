@@ -0,0 +1,104 @@
+#ifndef SCRAPSTORE_H
+#define SCRAPSTORE_H
+
+#include <string>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "metrics.h"
+
+/**
+ * The records the processes forked for one search hand to the process that forked them, packed into a single scrap
+ * file instead of one file each. The number of records is fixed up front and each has an index. A writer reserves the
+ * bytes of its record at the end of the file with an atomic counter in shared memory and writes it with pwrite, so
+ * processes forked after the store was created append without locking. The offset and size of every record are kept
+ * in the same shared memory. The file is preallocated, and is read back through mmap and mapped again when it has
+ * grown.
+ *
+ * The file is named after the process that created the store, so concurrent runs on the same scrap folder do not
+ * share it, and that process unlinks it when the store is destroyed.
+ */
+class ScrapStore
+{
+private:
+    // Where a record is in the file, written once by the process that writes the record
+    struct IndexEntry
+    {
+        uint64_t offset;
+        uint64_t size;
+        bool written;
+    };
+
+    // The end of the bytes reserved so far, followed by the index of every record
+    struct SharedIndex
+    {
+        std::atomic<uint64_t> reservedBytes{0};
+    };
+
+    std::string scrapPath;
+    pid_t owner;
+    int fd = -1;
+    size_t numRecords;
+
+    void *shared = nullptr;
+    size_t sharedBytes = 0;
+    SharedIndex *sharedIndex = nullptr;
+    IndexEntry *entries = nullptr;
+
+    const char *mapping = nullptr;
+    size_t mappedSize = 0;
+
+public:
+    /**
+     * Creates the scrap file in the scrap folder and the shared index of its records.
+     *
+     * @param scrapFolderPath The path to the folder where the scrap file will be stored
+     * @param numRecords The number of records that can be written
+     * @param preallocateBytes The size the file is preallocated to, which it can grow past
+     */
+    ScrapStore(const std::string &scrapFolderPath, size_t numRecords, size_t preallocateBytes);
+
+    /**
+     * Unmaps the file and the index. The process that created the store also closes and unlinks the file.
+     */
+    ~ScrapStore();
+
+    ScrapStore(const ScrapStore &) = delete;
+    ScrapStore &operator=(const ScrapStore &) = delete;
+
+    /**
+     * Get the path of the scrap file.
+     *
+     * @return const std::string& The path of the scrap file
+     */
+    const std::string &getPath() const { return this->scrapPath; }
+
+    /**
+     * Writes a record at the end of the file. Each record is written once, by any process forked after the store was
+     * created.
+     *
+     * @param record The index of the record
+     * @param data The bytes of the record
+     * @param size The number of bytes of the record
+     */
+    void write(size_t record, const void *data, size_t size);
+
+    /**
+     * Get the bytes of a record written by this process or by a process that has since exited.
+     *
+     * @param record The index of the record
+     * @param size Set to the number of bytes of the record
+     * @return const char* The bytes of the record, valid until the next read, or nullptr if it was never written
+     */
+    const char *read(size_t record, size_t &size);
+};
+
+#endif // SCRAPSTORE_H
@@ -0,0 +1,349 @@
+#include "server.h"
+
+/**
+ * Constructs a server over an already loaded cost grid and graph whose adjacency list has been built.
+ *
+ * @param graph The graph to search for the paths
+ * @param grid The cost grid to provide the bounds and weights for the graph
+ * @param options The socket path, the size of the worker pool and the node limits
+ * @param scrapFolderPath The path to the folder where scrap files will be stored
+ */
+QueryServer::QueryServer(Graph &graph, CostGrid &grid, ServerOptions options, std::string scrapFolderPath)
+    : graph(graph), grid(grid), options(options), scrapFolderPath(scrapFolderPath)
+{
+    if (this->options.numWorkers < 1)
+    {
+        throw std::invalid_argument("The server needs at least one worker.");
+    }
+}
+
+/**
+ * Listens on the socket and serves connections until a shutdown request, then prints the latency report.
+ *
+ * @return int 0 on a clean shutdown, or 43 if the socket cannot be set up
+ */
+int QueryServer::run()
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (this->options.socketPath.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Socket path is too long: " << this->options.socketPath << std::endl;
+        return 43;
+    }
+    std::strncpy(address.sun_path, this->options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    // Replace a socket left behind by a previous server
+    unlink(this->options.socketPath.c_str());
+
+    this->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (this->listenFd < 0 || bind(this->listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(this->listenFd, SOMAXCONN) < 0)
+    {
+        std::cerr << "Error listening on socket " << this->options.socketPath << ": " << std::strerror(errno) << std::endl;
+        return 43;
+    }
+
+    std::cout << "Listening on " << this->options.socketPath << " with " << this->options.numWorkers << " workers." << std::endl;
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < this->options.numWorkers; i++)
+    {
+        workers.emplace_back(&QueryServer::workerLoop, this);
+    }
+
+    while (!this->stopping)
+    {
+        int clientFd = accept(this->listenFd, nullptr, nullptr);
+        if (clientFd < 0)
+        {
+            if (errno != EINTR && !this->stopping)
+            {
+                std::cerr << "Error accepting connection: " << std::strerror(errno) << std::endl;
+            }
+            continue;
+        }
+
+        // Wait for room in the queue so the number of waiting connections stays bounded
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+        this->queueNotFull.wait(lock, [this]
+                                { return this->pendingConnections.size() < this->options.maxPendingConnections || this->stopping; });
+        if (this->stopping)
+        {
+            close(clientFd);
+            break;
+        }
+        this->pendingConnections.push_back(clientFd);
+        this->queueNotEmpty.notify_one();
+    }
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    close(this->listenFd);
+    unlink(this->options.socketPath.c_str());
+
+    std::cout << this->latencyReport();
+    return 0;
+}
+
+/**
+ * Takes accepted connections off the queue and serves them until the server stops.
+ */
+void QueryServer::workerLoop()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+        this->queueNotEmpty.wait(lock, [this]
+                                 { return !this->pendingConnections.empty() || this->stopping; });
+        if (this->pendingConnections.empty())
+        {
+            return;
+        }
+        int clientFd = this->pendingConnections.front();
+        this->pendingConnections.pop_front();
+        this->queueNotFull.notify_one();
+
+        // A connection served after the server stopped only has the requests already sent on it answered
+        this->activeConnections.insert(clientFd);
+        if (this->stopping)
+        {
+            shutdown(clientFd, SHUT_RD);
+        }
+        lock.unlock();
+
+        serveConnection(clientFd);
+    }
+}
+
+/**
+ * Answers the requests sent over a connection until the client closes it, then closes it.
+ *
+ * @param clientFd The file descriptor of the accepted connection
+ */
+void QueryServer::serveConnection(int clientFd)
+{
+    // Give up on a client that sends nothing for the idle timeout, so idle clients cannot hold every worker
+    timeval idleTimeout = {static_cast<time_t>(this->options.idleTimeoutSeconds), 0};
+    setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &idleTimeout, sizeof(idleTimeout));
+
+    std::string buffer;
+    char chunk[4096];
+    while (true)
+    {
+        // Reading ends when the client closes the connection, the idle timeout passes or the server stops
+        ssize_t numRead = recv(clientFd, chunk, sizeof(chunk), 0);
+        if (numRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numRead <= 0)
+        {
+            break;
+        }
+        buffer.append(chunk, numRead);
+
+        // Answer every complete line received so far
+        size_t newline;
+        bool connected = true;
+        while (connected && (newline = buffer.find('\n')) != std::string::npos)
+        {
+            std::string request = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            connected = sendResponse(clientFd, answerRequest(request));
+        }
+        if (!connected)
+        {
+            break;
+        }
+
+        // The rest of the buffer is an unfinished line, which must not grow without bound
+        if (buffer.size() > maxRequestLength)
+        {
+            sendResponse(clientFd, "Error: request line longer than " + std::to_string(maxRequestLength) + " bytes.\n\n");
+            break;
+        }
+    }
+
+    // Close the connection under the lock so stopping the server never shuts down a reused descriptor
+    std::lock_guard<std::mutex> lock(this->queueMutex);
+    this->activeConnections.erase(clientFd);
+    close(clientFd);
+}
+
+/**
+ * Sends a whole response over a connection.
+ *
+ * @param clientFd The file descriptor of the connection
+ * @param response The response to send
+ * @return bool True if the whole response was sent, false if the connection failed
+ */
+bool QueryServer::sendResponse(int clientFd, const std::string &response)
+{
+    for (size_t sent = 0; sent < response.size();)
+    {
+        ssize_t numSent = send(clientFd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (numSent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numSent <= 0)
+        {
+            return false;
+        }
+        sent += numSent;
+    }
+    return true;
+}
+
+/**
+ * Answers a single request line.
+ *
+ * @param request The request line without its newline
+ * @return std::string The response, ending with an empty line
+ */
+std::string QueryServer::answerRequest(const std::string &request)
+{
+    std::istringstream iss(request);
+    std::string command;
+    iss >> command;
+
+    if (command == "stats")
+    {
+        return latencyReport() + "\n";
+    }
+    if (command == "shutdown")
+    {
+        stop();
+        return "Shutting down.\n\n";
+    }
+    std::string patchPath;
+    if (command == "patch" && iss >> patchPath)
+    {
+        std::ostringstream response;
+        try
+        {
+            std::vector<CellCostChange> patch = readCostPatch(patchPath);
+            std::unique_lock<std::shared_mutex> lock(this->updateMutex);
+            writeCostPatchStats(applyCostPatch(this->grid, patch, this->scrapFolderPath), response);
+        }
+        catch (const std::exception &e)
+        {
+            response << "Error: " << e.what() << std::endl;
+        }
+        response << std::endl;
+        return response.str();
+    }
+
+    CellRect region;
+    if (command == "invalidate" && iss >> region.startRow >> region.startCol >> region.endRow >> region.endCol)
+    {
+        std::unique_lock<std::shared_mutex> lock(this->updateMutex);
+        return "Invalidated " + std::to_string(invalidateSubpaths(region)) + " cached subpaths.\n\n";
+    }
+
+    int row = 0, col = 0, node = 0;
+    bool add = command == "add" && iss >> row >> col;
+    if (add || (command == "remove" && iss >> node))
+    {
+        std::ostringstream response;
+        try
+        {
+            std::unique_lock<std::shared_mutex> lock(this->updateMutex);
+            writeGraphUpdateStats(add ? addGraphNode(this->graph, this->grid, row, col) : removeGraphNode(this->graph, node), add, response);
+        }
+        catch (const std::exception &e)
+        {
+            response << "Error: " << e.what() << std::endl;
+        }
+        response << std::endl;
+        return response.str();
+    }
+
+    std::istringstream nodesStream(request);
+    int startingNode, endingNode;
+    if (!(nodesStream >> startingNode >> endingNode))
+    {
+        return "Error: expected <node1> <node2>, patch <path>, invalidate <startRow> <startCol> <endRow> <endCol>, add <row> <col>, remove <node>, stats or shutdown.\n\n";
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::ostringstream response;
+    try
+    {
+        std::shared_lock<std::shared_mutex> lock(this->updateMutex);
+        LowestCostPath bestPath = findLowestCostPath(this->graph, this->grid, startingNode, endingNode, this->options.minNodes, this->options.maxNodes, this->scrapFolderPath);
+        response << "Lowest cost path found:" << std::endl;
+        writeLowestCostPath(bestPath, response);
+    }
+    catch (const std::exception &e)
+    {
+        response << "Error: " << e.what() << std::endl;
+    }
+    response << std::endl;
+
+    std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - startTime;
+    std::lock_guard<std::mutex> lock(this->latencyMutex);
+    this->latencies.push_back(latency.count());
+
+    return response.str();
+}
+
+/**
+ * Summarizes the latencies of the queries answered so far.
+ *
+ * @return std::string The number of queries and their p50, p90, p99 and maximum latency
+ */
+std::string QueryServer::latencyReport()
+{
+    std::vector<double> sorted;
+    {
+        std::lock_guard<std::mutex> lock(this->latencyMutex);
+        sorted = this->latencies;
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nearest-rank percentile of the sorted latencies
+    auto percentile = [&sorted](double p)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    };
+
+    std::ostringstream report;
+    report << "Queries answered: " << sorted.size() << std::endl;
+    if (!sorted.empty())
+    {
+        report << "Latency (ms): p50 " << percentile(50) << ", p90 " << percentile(90) << ", p99 " << percentile(99)
+               << ", max " << sorted.back() << std::endl;
+    }
+    writeSubpathCacheStats(report);
+    writeTileCacheStats(this->grid, report);
+    return report.str();
+}
+
+/**
+ * Stops accepting connections, stops reading new requests from the connections being served and wakes up every
+ * worker.
+ */
+void QueryServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        this->stopping = true;
+
+        // Wake up the workers blocked reading from idle clients. Requests already received are still answered
+        for (int clientFd : this->activeConnections)
+        {
+            shutdown(clientFd, SHUT_RD);
+        }
+    }
+    this->queueNotEmpty.notify_all();
+    this->queueNotFull.notify_all();
+
+    // Wake up the blocked accept call
+    shutdown(this->listenFd, SHUT_RDWR);
+}
@@ -0,0 +1,143 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "pathfinder.h"
+#include "graph.h"
+
+/**
+ * Settings for serving lowest cost path queries over a Unix domain socket.
+ */
+struct ServerOptions
+{
+    std::string socketPath;             // The path of the Unix domain socket to listen on
+    unsigned int numWorkers = 4;        // The number of worker threads answering connections
+    size_t maxPendingConnections = 64;  // The number of accepted connections that may wait for a worker
+    unsigned int idleTimeoutSeconds = 60; // How long a connection may go without a request before it is closed, or 0 to never close it
+    unsigned int minNodes = 3;          // The minimum number of nodes a valid path must contain
+    unsigned int maxNodes = 5;          // The maximum number of nodes a valid path can contain
+};
+
+/**
+ * Keeps a loaded cost grid, its graph and a warm subpath cache resident and answers lowest cost path queries sent
+ * over a Unix domain socket. The protocol is line based, with each request on its own line:
+ * - `<node1> <node2>` answers with the same content outputLowestCostPath writes.
+ * - `stats` answers with the number of queries answered and their latency percentiles.
+ * - `patch <path>` applies the cost patch file to the grid and answers with how the cached subpaths were updated.
+ * - `invalidate <startRow> <startCol> <endRow> <endCol>` drops the cached subpaths whose corridor overlaps the
+ *   rectangle and answers with how many were dropped.
+ * - `add <row> <col>` adds a node to the graph and `remove <node>` removes one, answering with how the edges and the
+ *   cached subpaths changed.
+ * - `shutdown` stops the server once the connections being served are finished.
+ * Every response ends with an empty line. Connections are served concurrently by a bounded pool of worker threads.
+ * A connection is closed when its client sends nothing for the idle timeout or a request line longer than
+ * maxRequestLength, and once the server stops, after answering the requests already received on it.
+ */
+class QueryServer
+{
+private:
+    Graph &graph;
+    CostGrid &grid;
+    ServerOptions options;
+    std::string scrapFolderPath;
+
+    int listenFd = -1;
+    std::atomic<bool> stopping = false;
+
+    // The longest request line answered, in bytes
+    static constexpr size_t maxRequestLength = 4096;
+
+    // Accepted connections waiting for a worker
+    std::deque<int> pendingConnections;
+    std::mutex queueMutex;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueNotFull;
+
+    // Connections being served by a worker, guarded by queueMutex so stopping can stop reading from them
+    std::unordered_set<int> activeConnections;
+
+    // Held shared while answering a query and exclusively while applying a cost patch, dropping cached subpaths or
+    // adding or removing a node
+    std::shared_mutex updateMutex;
+
+    // Latency of every query answered, in milliseconds
+    std::vector<double> latencies;
+    std::mutex latencyMutex;
+
+    /**
+     * Takes accepted connections off the queue and serves them until the server stops.
+     */
+    void workerLoop();
+
+    /**
+     * Answers the requests sent over a connection until the client closes it, then closes it.
+     *
+     * @param clientFd The file descriptor of the accepted connection
+     */
+    void serveConnection(int clientFd);
+
+    /**
+     * Sends a whole response over a connection.
+     *
+     * @param clientFd The file descriptor of the connection
+     * @param response The response to send
+     * @return bool True if the whole response was sent, false if the connection failed
+     */
+    bool sendResponse(int clientFd, const std::string &response);
+
+    /**
+     * Answers a single request line.
+     *
+     * @param request The request line without its newline
+     * @return std::string The response, ending with an empty line
+     */
+    std::string answerRequest(const std::string &request);
+
+    /**
+     * Summarizes the latencies of the queries answered so far.
+     *
+     * @return std::string The number of queries, their p50, p90, p99 and maximum latency and the subpath cache counts
+     */
+    std::string latencyReport();
+
+    /**
+     * Stops accepting connections, stops reading new requests from the connections being served and wakes up every
+     * worker.
+     */
+    void stop();
+
+public:
+    /**
+     * Constructs a server over an already loaded cost grid and graph whose adjacency list has been built.
+     *
+     * @param graph The graph to search for the paths
+     * @param grid The cost grid to provide the bounds and weights for the graph
+     * @param options The socket path, the size of the worker pool and the node limits
+     * @param scrapFolderPath The path to the folder where scrap files will be stored
+     */
+    QueryServer(Graph &graph, CostGrid &grid, ServerOptions options, std::string scrapFolderPath);
+
+    /**
+     * Listens on the socket and serves connections until a shutdown request, then prints the latency report.
+     *
+     * @return int 0 on a clean shutdown, or 43 if the socket cannot be set up
+     */
+    int run();
+};
+
+#endif // SERVER_H
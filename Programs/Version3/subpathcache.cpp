@@ -0,0 +1,254 @@
+#include "subpathcache.h"
+
+/**
+ * Packs the start and end positions of a subpath into a key.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @return SubpathKey The packed key
+ */
+SubpathKey packSubpathKey(std::pair<int, int> startPos, std::pair<int, int> endPos)
+{
+    for (int coordinate : {startPos.first, startPos.second, endPos.first, endPos.second})
+    {
+        if (coordinate < 0)
+        {
+            throw std::out_of_range("Subpath coordinates must not be negative. Given: " + std::to_string(coordinate));
+        }
+    }
+    return SubpathKey{(static_cast<uint64_t>(startPos.first) << 32) | static_cast<uint32_t>(startPos.second),
+                      (static_cast<uint64_t>(endPos.first) << 32) | static_cast<uint32_t>(endPos.second)};
+}
+
+/**
+ * Finds the slot holding a key, or the empty slot where it would be inserted.
+ *
+ * @param key The packed key
+ * @return size_t The index of the slot
+ */
+size_t SubpathCache::findSlot(const SubpathKey &key) const
+{
+    // The number of slots is a power of 2, so the mask wraps the probe around the table
+    size_t mask = this->slots.size() - 1;
+    size_t slot = SubpathKeyHash()(key) & mask;
+    while (this->slots[slot].entryIndex != 0 && this->slots[slot].key != key)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * Doubles the number of slots and reinserts every key.
+ */
+void SubpathCache::grow()
+{
+    std::vector<Slot> oldSlots(this->slots.size() * 2, Slot{{0, 0}, 0});
+    oldSlots.swap(this->slots);
+    for (const Slot &slot : oldSlots)
+    {
+        if (slot.entryIndex != 0)
+        {
+            this->slots[findSlot(slot.key)] = slot;
+        }
+    }
+}
+
+/**
+ * Looks up the subpath between two positions.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @return const Entry* The cached entry, or nullptr if the subpath is not in the cache
+ */
+const SubpathCache::Entry *SubpathCache::find(std::pair<int, int> startPos, std::pair<int, int> endPos) const
+{
+    const Slot &slot = this->slots[findSlot(packSubpathKey(startPos, endPos))];
+    if (slot.entryIndex == 0)
+    {
+        return nullptr;
+    }
+    size_t index = slot.entryIndex - 1;
+    return &entryAt(index);
+}
+
+/**
+ * Get the search rectangle of a subpath.
+ *
+ * @param key The packed key of the subpath
+ * @return CellRect The rectangle enclosing its start and end positions, padded
+ */
+CellRect SubpathCache::searchRect(const SubpathKey &key) const
+{
+    int startRow = static_cast<int>(key.start >> 32), startCol = static_cast<int>(key.start & 0xFFFFFFFF);
+    int endRow = static_cast<int>(key.end >> 32), endCol = static_cast<int>(key.end & 0xFFFFFFFF);
+    return CellRect{std::min(startRow, endRow) - this->padding, std::max(startRow, endRow) + this->padding,
+                    std::min(startCol, endCol) - this->padding, std::max(startCol, endCol) + this->padding};
+}
+
+/**
+ * Inserts the subpath between two positions, unless it is already in the cache.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @param cost The cost of the subpath
+ * @param path The cells of the subpath
+ * @return const Entry& The entry now in the cache, which is the existing one if the subpath was already cached
+ */
+const SubpathCache::Entry &SubpathCache::emplace(std::pair<int, int> startPos, std::pair<int, int> endPos, float cost, CompactPath path)
+{
+    SubpathKey key = packSubpathKey(startPos, endPos);
+    size_t slot = findSlot(key);
+    if (this->slots[slot].entryIndex == 0)
+    {
+        // Keep the load factor at or below 3/4 so probe sequences stay short
+        if ((this->numEntries + 1) * 4 > this->slots.size() * 3)
+        {
+            grow();
+            slot = findSlot(key);
+        }
+
+        // Reuse the place of an erased entry before growing the arena
+        size_t index;
+        if (!this->freeEntries.empty())
+        {
+            index = this->freeEntries.back();
+            this->freeEntries.pop_back();
+            this->entryKeys[index] = key;
+        }
+        else
+        {
+            index = this->entryKeys.size();
+            if (index % chunkSize == 0)
+            {
+                this->arena.push_back(std::make_unique<Entry[]>(chunkSize));
+            }
+            this->entryKeys.push_back(key);
+        }
+        Entry &entry = entryAt(index);
+        entry.first = cost;
+        entry.second = std::move(path);
+        this->slots[slot] = Slot{key, static_cast<uint32_t>(index + 1)};
+        this->numEntries++;
+
+        // List the entry in every bucket its search rectangle overlaps
+        CellRect rect = searchRect(key);
+        for (int bucketRow = std::max(rect.startRow, 0) >> bucketShift; bucketRow <= rect.endRow >> bucketShift; bucketRow++)
+        {
+            for (int bucketCol = std::max(rect.startCol, 0) >> bucketShift; bucketCol <= rect.endCol >> bucketShift; bucketCol++)
+            {
+                this->buckets[bucketKey(bucketRow, bucketCol)].push_back(static_cast<uint32_t>(index));
+            }
+        }
+    }
+
+    return entryAt(this->slots[slot].entryIndex - 1);
+}
+
+/**
+ * Removes the entry in a slot from the buckets, the arena and the table.
+ *
+ * @param slot The index of the slot holding the entry
+ */
+void SubpathCache::eraseSlot(size_t slot)
+{
+    size_t mask = this->slots.size() - 1;
+    SubpathKey key = this->slots[slot].key;
+    size_t index = this->slots[slot].entryIndex - 1;
+
+    // Take the entry out of the buckets its search rectangle overlaps
+    CellRect rect = searchRect(key);
+    for (int bucketRow = std::max(rect.startRow, 0) >> bucketShift; bucketRow <= rect.endRow >> bucketShift; bucketRow++)
+    {
+        for (int bucketCol = std::max(rect.startCol, 0) >> bucketShift; bucketCol <= rect.endCol >> bucketShift; bucketCol++)
+        {
+            auto bucket = this->buckets.find(bucketKey(bucketRow, bucketCol));
+            std::vector<uint32_t> &indices = bucket->second;
+            *std::find(indices.begin(), indices.end(), static_cast<uint32_t>(index)) = indices.back();
+            indices.pop_back();
+            if (indices.empty())
+            {
+                this->buckets.erase(bucket);
+            }
+        }
+    }
+
+    // Empty the entry so its cells are released, and keep its place for the next insertion
+    entryAt(index) = Entry();
+    this->freeEntries.push_back(static_cast<uint32_t>(index));
+    this->numEntries--;
+
+    // Remove the slot by shifting back the keys after it that would no longer be reachable from their home slot
+    this->slots[slot] = Slot{{0, 0}, 0};
+    for (size_t next = (slot + 1) & mask; this->slots[next].entryIndex != 0; next = (next + 1) & mask)
+    {
+        size_t home = SubpathKeyHash()(this->slots[next].key) & mask;
+        bool reachable = slot <= next ? (home > slot && home <= next) : (home > slot || home <= next);
+        if (!reachable)
+        {
+            this->slots[slot] = this->slots[next];
+            this->slots[next] = Slot{{0, 0}, 0};
+            slot = next;
+        }
+    }
+}
+
+/**
+ * Erases the subpath between two positions. A reference to its entry must not be used afterwards.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @return bool True if the subpath was in the cache, false otherwise
+ */
+bool SubpathCache::erase(std::pair<int, int> startPos, std::pair<int, int> endPos)
+{
+    size_t slot = findSlot(packSubpathKey(startPos, endPos));
+    if (this->slots[slot].entryIndex == 0)
+    {
+        return false;
+    }
+    eraseSlot(slot);
+    return true;
+}
+
+/**
+ * Erases every subpath whose search rectangle overlaps a region. References to the erased entries must not be
+ * used afterwards.
+ *
+ * @param region The region of the grid
+ * @return std::vector<SubpathKey> The packed keys of the erased subpaths
+ */
+std::vector<SubpathKey> SubpathCache::invalidate(const CellRect &region)
+{
+    std::vector<SubpathKey> erasedKeys;
+    forEachOverlapping(region, [&erasedKeys](const SubpathKey &key, Entry &)
+                       { erasedKeys.push_back(key); });
+
+    for (const SubpathKey &key : erasedKeys)
+    {
+        eraseSlot(findSlot(key));
+    }
+
+    return erasedKeys;
+}
+
+/**
+ * Get the memory held by the cache: the table, the arena, the spatial index and the packed cells of every entry.
+ *
+ * @return size_t The number of bytes held
+ */
+size_t SubpathCache::memoryUsage() const
+{
+    size_t bytes = this->slots.capacity() * sizeof(Slot) + this->arena.capacity() * sizeof(std::unique_ptr<Entry[]>) +
+                   this->arena.size() * chunkSize * sizeof(Entry) + this->entryKeys.capacity() * sizeof(SubpathKey) +
+                   this->freeEntries.capacity() * sizeof(uint32_t);
+    for (const auto &[bucketKey, indices] : this->buckets)
+    {
+        bytes += sizeof(bucketKey) + sizeof(indices) + indices.capacity() * sizeof(uint32_t);
+    }
+    for (size_t index = 0; index < this->entryKeys.size(); index++)
+    {
+        bytes += entryAt(index).second.packed().capacity();
+    }
+    return bytes;
+}
@@ -0,0 +1,287 @@
+#ifndef SUBPATHCACHE_H
+#define SUBPATHCACHE_H
+
+#include <vector>
+#include <utility>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include "compactpath.h"
+
+/**
+ * The start and end positions of a subpath packed into a 128-bit key, each position as its row in the high 32 bits
+ * and its column in the low 32 bits, so every cell of any grid has its own key.
+ */
+struct SubpathKey
+{
+    uint64_t start;
+    uint64_t end;
+
+    bool operator==(const SubpathKey &other) const { return this->start == other.start && this->end == other.end; }
+};
+
+/**
+ * Packs the start and end positions of a subpath into a key.
+ *
+ * @param startPos The starting position of the subpath
+ * @param endPos The ending position of the subpath
+ * @return SubpathKey The packed key
+ */
+SubpathKey packSubpathKey(std::pair<int, int> startPos, std::pair<int, int> endPos);
+
+/**
+ * Mixes the bits of a packed key so every input bit affects every output bit (the splitmix64 finalizer). Keys of
+ * nearby or swapped coordinates then land in unrelated slots.
+ *
+ * @param key The packed key
+ * @return uint64_t The mixed hash of the key
+ */
+inline uint64_t mixSubpathKey(uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+/**
+ * Hashes a packed key by mixing its ending position into its starting position, so keys can be used in standard
+ * unordered containers.
+ */
+struct SubpathKeyHash
+{
+    size_t operator()(const SubpathKey &key) const { return mixSubpathKey(key.start ^ mixSubpathKey(key.end)); }
+};
+
+/**
+ * A rectangle of grid cells, with inclusive bounds.
+ */
+struct CellRect
+{
+    int startRow;
+    int endRow;
+    int startCol;
+    int endCol;
+
+    /**
+     * Checks whether the rectangle shares a cell with another.
+     *
+     * @param other The other rectangle
+     * @return bool True if the rectangles overlap, false otherwise
+     */
+    bool overlaps(const CellRect &other) const
+    {
+        return this->startRow <= other.endRow && other.startRow <= this->endRow && this->startCol <= other.endCol && other.startCol <= this->endCol;
+    }
+};
+
+/**
+ * Cache of the cost and cells of the subpaths searched so far, keyed by their start and end positions.
+ *
+ * The keys live in an open-addressing table with linear probing, where each slot holds a packed key and the index of
+ * its entry. The entries live in an arena of fixed size chunks that only grows, so references to entries stay valid
+ * while the table grows. Erased entries are emptied and their place in the arena is reused by later insertions. The
+ * cache is not synchronized.
+ *
+ * The search rectangle of each entry, the rectangle enclosing its start and end positions padded by the padding the
+ * cache was constructed with, is indexed in uniform buckets of the grid. An entry is listed in every bucket its
+ * rectangle overlaps, so the entries overlapping a region are found by visiting the buckets of the region only.
+ */
+class SubpathCache
+{
+public:
+    // The cost of a subpath and its cells
+    using Entry = std::pair<float, CompactPath>;
+
+private:
+    // A slot of the table, empty while entryIndex is 0
+    struct Slot
+    {
+        SubpathKey key;
+        uint32_t entryIndex; // One more than the index of the entry in the arena
+    };
+
+    static constexpr size_t chunkSize = 1024;
+    static constexpr size_t initialCapacity = 64;
+
+    // The buckets of the spatial index are squares of 2^bucketShift cells
+    static constexpr int bucketShift = 5;
+
+    std::vector<Slot> slots;
+    std::vector<std::unique_ptr<Entry[]>> arena;
+    std::vector<SubpathKey> entryKeys; // The packed key of each entry of the arena
+    std::vector<uint32_t> freeEntries; // The indices of the erased entries of the arena
+    size_t numEntries = 0;
+    int padding;
+
+    // The indices of the entries whose search rectangle overlaps each bucket, by the row and column of the bucket
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+
+    /**
+     * Finds the slot holding a key, or the empty slot where it would be inserted.
+     *
+     * @param key The packed key
+     * @return size_t The index of the slot
+     */
+    size_t findSlot(const SubpathKey &key) const;
+
+    /**
+     * Doubles the number of slots and reinserts every key.
+     */
+    void grow();
+
+    /**
+     * Removes the entry in a slot from the buckets, the arena and the table.
+     *
+     * @param slot The index of the slot holding the entry
+     */
+    void eraseSlot(size_t slot);
+
+    /**
+     * Get the entry at an index of the arena.
+     *
+     * @param index The index of the entry
+     * @return Entry& The entry
+     */
+    Entry &entryAt(size_t index) const { return this->arena[index / chunkSize][index % chunkSize]; }
+
+    /**
+     * Get the search rectangle of a subpath.
+     *
+     * @param key The packed key of the subpath
+     * @return CellRect The rectangle enclosing its start and end positions, padded
+     */
+    CellRect searchRect(const SubpathKey &key) const;
+
+    /**
+     * Get the key of the bucket holding a cell.
+     *
+     * @param bucketRow The row of the bucket
+     * @param bucketCol The column of the bucket
+     * @return uint64_t The key of the bucket, its row in the high 32 bits and its column in the low 32 bits
+     */
+    static uint64_t bucketKey(int bucketRow, int bucketCol) { return (static_cast<uint64_t>(static_cast<uint32_t>(bucketRow)) << 32) | static_cast<uint32_t>(bucketCol); }
+
+public:
+    /**
+     * Constructs an empty cache.
+     *
+     * @param padding The number of cells the rectangle enclosing a subpath's start and end positions is padded by to
+     * form its search rectangle
+     */
+    explicit SubpathCache(int padding = 0) : slots(initialCapacity, Slot{{0, 0}, 0}), padding(padding) {}
+
+    /**
+     * Looks up the subpath between two positions.
+     *
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @return const Entry* The cached entry, or nullptr if the subpath is not in the cache
+     */
+    const Entry *find(std::pair<int, int> startPos, std::pair<int, int> endPos) const;
+
+    /**
+     * Looks up the subpath between two positions so its entry can be updated in place.
+     *
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @return Entry* The cached entry, or nullptr if the subpath is not in the cache
+     */
+    Entry *find(std::pair<int, int> startPos, std::pair<int, int> endPos)
+    {
+        return const_cast<Entry *>(static_cast<const SubpathCache *>(this)->find(startPos, endPos));
+    }
+
+    /**
+     * Calls a function with every entry whose search rectangle overlaps a region, once each. The function may update
+     * the entry in place, as long as its path keeps the same starting and ending positions, but must not insert or
+     * erase entries.
+     *
+     * @param region The region of the grid
+     * @param function The function to call with the packed key and the entry of each overlapping subpath
+     */
+    template <typename Function>
+    void forEachOverlapping(const CellRect &region, Function function)
+    {
+        int firstBucketRow = std::max(region.startRow, 0) >> bucketShift;
+        int firstBucketCol = std::max(region.startCol, 0) >> bucketShift;
+        for (int bucketRow = firstBucketRow; bucketRow <= std::max(region.endRow, 0) >> bucketShift; bucketRow++)
+        {
+            for (int bucketCol = firstBucketCol; bucketCol <= std::max(region.endCol, 0) >> bucketShift; bucketCol++)
+            {
+                auto bucket = this->buckets.find(bucketKey(bucketRow, bucketCol));
+                if (bucket == this->buckets.end())
+                {
+                    continue;
+                }
+                for (uint32_t index : bucket->second)
+                {
+                    CellRect rect = searchRect(this->entryKeys[index]);
+                    if (!rect.overlaps(region))
+                    {
+                        continue;
+                    }
+
+                    // An entry is listed in every bucket its rectangle overlaps, so only visit it from the bucket
+                    // holding the first cell of its overlap with the region
+                    if ((std::max({rect.startRow, region.startRow, 0}) >> bucketShift) == bucketRow &&
+                        (std::max({rect.startCol, region.startCol, 0}) >> bucketShift) == bucketCol)
+                    {
+                        function(this->entryKeys[index], entryAt(index));
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Inserts the subpath between two positions, unless it is already in the cache.
+     *
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @param cost The cost of the subpath
+     * @param path The cells of the subpath
+     * @return const Entry& The entry now in the cache, which is the existing one if the subpath was already cached
+     */
+    const Entry &emplace(std::pair<int, int> startPos, std::pair<int, int> endPos, float cost, CompactPath path);
+
+    /**
+     * Erases the subpath between two positions. A reference to its entry must not be used afterwards.
+     *
+     * @param startPos The starting position of the subpath
+     * @param endPos The ending position of the subpath
+     * @return bool True if the subpath was in the cache, false otherwise
+     */
+    bool erase(std::pair<int, int> startPos, std::pair<int, int> endPos);
+
+    /**
+     * Erases every subpath whose search rectangle overlaps a region. References to the erased entries must not be
+     * used afterwards.
+     *
+     * @param region The region of the grid
+     * @return std::vector<SubpathKey> The packed keys of the erased subpaths
+     */
+    std::vector<SubpathKey> invalidate(const CellRect &region);
+
+    /**
+     * Get the number of subpaths in the cache.
+     *
+     * @return size_t The number of subpaths
+     */
+    size_t size() const { return this->numEntries; }
+
+    /**
+     * Get the memory held by the cache: the table, the arena, the spatial index and the packed cells of every entry.
+     *
+     * @return size_t The number of bytes held
+     */
+    size_t memoryUsage() const;
+};
+
+#endif // SUBPATHCACHE_H
@@ -2,4 +2,245 @@
 
 #ifdef DEBUG
 
+/**
+ * Parses the DEBUG_CATEGORIES environment variable into a bitmask of debug categories.
+ *
+ * @return unsigned int The bitmask of the enabled categories, all of them if the variable is not set
+ */
+unsigned int parseDebugCategories()
+{
+    const char *value = std::getenv("DEBUG_CATEGORIES");
+    if (value == nullptr || std::string(value) == "all")
+    {
+        return ~0u;
+    }
+
+    unsigned int categories = 0;
+    std::string name;
+    for (const char *c = value;; c++)
+    {
+        if (*c == ',' || *c == '\0')
+        {
+            if (name == "paths")
+            {
+                categories |= static_cast<unsigned int>(DebugCategory::Paths);
+            }
+            else if (name == "search")
+            {
+                categories |= static_cast<unsigned int>(DebugCategory::Search);
+            }
+            else if (!name.empty() && name != "none")
+            {
+                std::cerr << "Unknown debug category: " << name << std::endl;
+            }
+            name.clear();
+            if (*c == '\0')
+            {
+                break;
+            }
+        }
+        else
+        {
+            name += *c;
+        }
+    }
+    return categories;
+}
+
+const unsigned int enabledDebugCategories = parseDebugCategories();
+
+// The number of queued bytes that wakes the flusher, and the number above which writers wait for it
+const size_t debugLogFlushThreshold = 64 << 10;
+const size_t debugLogCapacity = 8 << 20;
+
+// The number of files the flusher keeps open before closing them all
+const size_t maxOpenDebugFiles = 256;
+
+/**
+ * The debug log of a process: the messages queued for each file and the state of the thread writing them.
+ */
+struct DebugLog
+{
+    std::mutex mutex;
+    std::condition_variable flushRequested; // Wakes the flusher when enough is queued or the process exits
+    std::condition_variable flushed;        // Wakes writers waiting for space and the exit handler
+
+    std::unordered_map<std::string, std::string> pending; // Queued messages by file path
+    size_t pendingBytes = 0;
+    bool flusherRunning = false;
+    bool stopping = false;
+
+    // Files opened by the flusher by path, only used by the thread writing the queued messages
+    std::unordered_map<std::string, int> openFiles;
+};
+
+/**
+ * The debug log of this process. A forked process starts a new one, so the messages queued by its parent are not
+ * written twice and no lock or thread of its parent is used.
+ */
+DebugLog *debugLog = nullptr;
+std::once_flag debugLogInitialized;
+
+/**
+ * Appends queued messages to their files, opening the files that are not open yet.
+ *
+ * @param log The debug log the messages were queued in
+ * @param messages The queued messages by file path
+ */
+void writeDebugMessages(DebugLog *log, const std::unordered_map<std::string, std::string> &messages)
+{
+    for (const auto &[filePath, text] : messages)
+    {
+        auto file = log->openFiles.find(filePath);
+        if (file == log->openFiles.end())
+        {
+            if (log->openFiles.size() >= maxOpenDebugFiles)
+            {
+                for (const auto &[openPath, fd] : log->openFiles)
+                {
+                    close(fd);
+                }
+                log->openFiles.clear();
+            }
+
+            int fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd < 0)
+            {
+                std::cerr << "Unable to open file: " << filePath << std::endl;
+                continue;
+            }
+            file = log->openFiles.emplace(filePath, fd).first;
+        }
+
+        for (size_t written = 0; written < text.size();)
+        {
+            ssize_t numWritten = write(file->second, text.data() + written, text.size() - written);
+            if (numWritten < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (numWritten <= 0)
+            {
+                std::cerr << "Unable to write to file: " << filePath << std::endl;
+                break;
+            }
+            written += numWritten;
+        }
+    }
+}
+
+/**
+ * Writes the queued messages of a debug log whenever enough are queued, or every 100 ms, until the process exits.
+ *
+ * @param log The debug log to write the messages of
+ */
+void flushDebugLog(DebugLog *log)
+{
+    std::unique_lock<std::mutex> lock(log->mutex);
+    while (!log->stopping || log->pendingBytes > 0)
+    {
+        log->flushRequested.wait_for(lock, std::chrono::milliseconds(100), [log]
+                                     { return log->pendingBytes >= debugLogFlushThreshold || log->stopping; });
+
+        // Take the queued messages so writers can keep queueing while they are written
+        std::unordered_map<std::string, std::string> messages;
+        messages.swap(log->pending);
+        log->pendingBytes = 0;
+        log->flushed.notify_all();
+
+        lock.unlock();
+        writeDebugMessages(log, messages);
+        lock.lock();
+    }
+
+    log->flusherRunning = false;
+    log->flushed.notify_all();
+}
+
+/**
+ * Writes every message queued by this process before it exits.
+ */
+void closeDebugLog()
+{
+    DebugLog *log = debugLog;
+    std::unique_lock<std::mutex> lock(log->mutex);
+    log->stopping = true;
+    log->flushRequested.notify_one();
+    log->flushed.wait(lock, [log]
+                      { return !log->flusherRunning; });
+
+    // Nothing was queued since the flusher stopped, unless it was never started
+    writeDebugMessages(log, log->pending);
+    log->pending.clear();
+    for (const auto &[filePath, fd] : log->openFiles)
+    {
+        close(fd);
+    }
+    log->openFiles.clear();
+}
+
+/**
+ * Creates the debug log of this process and registers the handlers that write it at exit and replace it after a fork.
+ */
+void initDebugLog()
+{
+    debugLog = new DebugLog();
+    std::atexit(closeDebugLog);
+
+    // Hold the lock across a fork so the log is not copied mid-update, then give the forked process a log of its own.
+    // The log of the parent is left to the parent, since its lock and flusher do not exist in the forked process.
+    pthread_atfork([]
+                   { debugLog->mutex.lock(); },
+                   []
+                   { debugLog->mutex.unlock(); },
+                   []
+                   { debugLog = new DebugLog(); });
+}
+
+/**
+ * Queues a debug message to be appended to a file. Messages are buffered per process and written by a background
+ * thread to files that stay open, and every queued message is written when the process exits.
+ *
+ * @param filePath The path to the file to append the message to
+ * @param message The message to append
+ * @param newline Whether to end the message with a newline
+ */
+void writeDebugLog(const std::string &filePath, const std::string &message, bool newline)
+{
+    std::call_once(debugLogInitialized, initDebugLog);
+
+    DebugLog *log = debugLog;
+    std::unique_lock<std::mutex> lock(log->mutex);
+    if (log->stopping && !log->flusherRunning)
+    {
+        // The process is exiting and its queued messages were written, so write the message directly
+        writeDebugMessages(log, {{filePath, message + (newline ? "\n" : "")}});
+        return;
+    }
+
+    // Start the flusher of this process on its first message
+    if (!log->flusherRunning && !log->stopping)
+    {
+        log->flusherRunning = true;
+        std::thread(flushDebugLog, log).detach();
+    }
+
+    // Wait for the flusher to catch up rather than drop messages
+    log->flushed.wait(lock, [log]
+                      { return log->pendingBytes < debugLogCapacity || !log->flusherRunning; });
+
+    std::string &text = log->pending[filePath];
+    text += message;
+    if (newline)
+    {
+        text += '\n';
+    }
+    log->pendingBytes += message.size() + newline;
+
+    if (log->pendingBytes >= debugLogFlushThreshold)
+    {
+        log->flushRequested.notify_one();
+    }
+}
+
 #endif
@@ -6,32 +6,76 @@
  * to output debug messages to the console and a file, respectively.
  *
  * DEBUG_CONSOLE(Out): Prints the debug message `Out` to the console if debugging is enabled.
- * DEBUG_FILE(Out, filePath): Writes the debug message `Out` to the specified file if debugging is enabled.
+ * DEBUG_FILE(Category, Out, filePath): Writes the debug message `Out` to the specified file if debugging is enabled
+ * and its category is enabled. The message is only formatted when its category is enabled.
+ *
+ * The categories written are set by the DEBUG_CATEGORIES environment variable as a comma separated list of their
+ * names, or `all` (the default) or `none`.
  */
 #ifdef DEBUG
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 
 class Graph; // Forward declaration of Graph class
 
+/**
+ * The categories of debug messages written to files.
+ */
+enum class DebugCategory
+{
+    Paths = 1 << 0, // Enumerating the valid paths, written to debug_valid_paths.txt
+    Search = 1 << 1 // Searching the grid for a subpath, written to a debug_grandchild file per subpath
+};
+
+/**
+ * The bitmask of the debug categories enabled by the DEBUG_CATEGORIES environment variable.
+ */
+extern const unsigned int enabledDebugCategories;
+
+/**
+ * Get whether debug messages of a category are written.
+ *
+ * @param category The category of the messages
+ * @return bool True if the category is enabled, false otherwise
+ */
+inline bool debugCategoryEnabled(DebugCategory category)
+{
+    return (enabledDebugCategories & static_cast<unsigned int>(category)) != 0;
+}
+
+/**
+ * Queues a debug message to be appended to a file. Messages are buffered per process and written by a background
+ * thread to files that stay open, and every queued message is written when the process exits.
+ *
+ * @param filePath The path to the file to append the message to
+ * @param message The message to append
+ * @param newline Whether to end the message with a newline
+ */
+void writeDebugLog(const std::string &filePath, const std::string &message, bool newline);
+
 // DEBUG_FILE with optional newline parameter (default is true)
-#define DEBUG_FILE_DEF(message, filepath, newline)                         \
-    {                                                                      \
-        std::ofstream file(filepath, std::ios_base::app);                  \
-        if (file.is_open())                                                \
-        {                                                                  \
-            file << message;                                               \
-            if (newline)                                                   \
-                file << std::endl;                                         \
-            file.close();                                                  \
-        }                                                                  \
-        else                                                               \
-        {                                                                  \
-            std::cerr << "Unable to open file: " << filepath << std::endl; \
-        }                                                                  \
+#define DEBUG_FILE_DEF(category, message, filepath, newline) \
+    {                                                        \
+        if (debugCategoryEnabled(category))                  \
+        {                                                    \
+            writeDebugLog(filepath, message, newline);       \
+        }                                                    \
     }
-#define DEBUG_FILE_ENDL(message, filepath) DEBUG_FILE_DEF(message, filepath, true)
-#define GET_DEBUG_FILE_MACRO(_1, _2, _3, NAME, ...) NAME
+#define DEBUG_FILE_ENDL(category, message, filepath) DEBUG_FILE_DEF(category, message, filepath, true)
+#define GET_DEBUG_FILE_MACRO(_1, _2, _3, _4, NAME, ...) NAME
 #define DEBUG_FILE(...) GET_DEBUG_FILE_MACRO(__VA_ARGS__, DEBUG_FILE_DEF, DEBUG_FILE_ENDL)(__VA_ARGS__)
 
 // DEBUG_CONSOLE with optional newline parameter (default is true)
@@ -0,0 +1,169 @@
+#include "tiledgrid.h"
+
+/**
+ * Opens a tiled grid file. Only its header is read.
+ *
+ * @param gridPath The path to the tiled grid file
+ * @param budgetBytes The memory budget of the tile cache, which always holds at least one tile
+ */
+TiledGrid::TiledGrid(const std::string &gridPath, size_t budgetBytes) : gridPath(gridPath)
+{
+    this->fd = open(gridPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (this->fd < 0)
+    {
+        throw std::runtime_error("Unable to open tiled grid file: " + gridPath + ": " + std::strerror(errno));
+    }
+
+    char header[tiledGridHeaderSize];
+    if (pread(this->fd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        !std::equal(header, header + sizeof(tiledGridMagic), tiledGridMagic))
+    {
+        close(this->fd);
+        throw std::runtime_error("Not a tiled grid file: " + gridPath);
+    }
+
+    uint32_t dimensions[3];
+    std::memcpy(dimensions, header + sizeof(tiledGridMagic), sizeof(dimensions));
+    uint32_t width = dimensions[0], height = dimensions[1], tileSize = dimensions[2];
+    if (width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX || tileSize == 0 || tileSize > 65536)
+    {
+        close(this->fd);
+        throw std::invalid_argument("Tiled grid dimensions must be positive. Given: width=" + std::to_string(width) + ", height=" +
+                                    std::to_string(height) + ", tile size=" + std::to_string(tileSize));
+    }
+
+    this->numRows = height;
+    this->numCols = width;
+    this->tileSize = tileSize;
+    this->numTileRows = (height + tileSize - 1) / tileSize;
+    this->numTileCols = (width + tileSize - 1) / tileSize;
+
+    size_t tileBytes = (size_t)tileSize * tileSize * sizeof(float);
+    this->maxTiles = std::max<size_t>(1, budgetBytes / tileBytes);
+    this->stats.budgetBytes = budgetBytes;
+}
+
+TiledGrid::~TiledGrid()
+{
+    close(this->fd);
+}
+
+/**
+ * Reads a tile from the file.
+ *
+ * @param index The index of the tile, row by row across the grid
+ * @return std::shared_ptr<const Tile> The costs of the tile
+ */
+std::shared_ptr<const TiledGrid::Tile> TiledGrid::readTile(int index) const
+{
+    auto tile = std::make_shared<Tile>((size_t)this->tileSize * this->tileSize);
+    size_t tileBytes = tile->size() * sizeof(float);
+    off_t offset = tiledGridHeaderSize + (off_t)index * tileBytes;
+
+    // pread may return fewer bytes than asked for, so read until the tile is full
+    char *bytes = reinterpret_cast<char *>(tile->data());
+    for (size_t done = 0; done < tileBytes;)
+    {
+        ssize_t numRead = pread(this->fd, bytes + done, tileBytes - done, offset + done);
+        if (numRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numRead <= 0)
+        {
+            throw std::runtime_error("Error reading tile " + std::to_string(index) + " from file: " + this->gridPath);
+        }
+        done += numRead;
+    }
+    return tile;
+}
+
+/**
+ * Asks the kernel to read the tiles around a tile ahead, unless they are cached.
+ *
+ * @param tileRow The row of the tile
+ * @param tileCol The column of the tile
+ */
+void TiledGrid::prefetchAround(int tileRow, int tileCol) const
+{
+    size_t tileBytes = (size_t)this->tileSize * this->tileSize * sizeof(float);
+    for (int r = std::max(0, tileRow - 1); r <= std::min(this->numTileRows - 1, tileRow + 1); r++)
+    {
+        for (int c = std::max(0, tileCol - 1); c <= std::min(this->numTileCols - 1, tileCol + 1); c++)
+        {
+            int index = r * this->numTileCols + c;
+            if (this->tiles.count(index) == 0)
+            {
+                posix_fadvise(this->fd, tiledGridHeaderSize + (off_t)index * tileBytes, tileBytes, POSIX_FADV_WILLNEED);
+            }
+        }
+    }
+}
+
+/**
+ * Get a tile from the cache, reading it from the file on a miss.
+ *
+ * @param tileRow The row of the tile
+ * @param tileCol The column of the tile
+ * @return std::shared_ptr<const Tile> The costs of the tile, row by row
+ */
+std::shared_ptr<const TiledGrid::Tile> TiledGrid::getTile(int tileRow, int tileCol)
+{
+    int index = tileRow * this->numTileCols + tileCol;
+
+    std::lock_guard<std::mutex> lock(this->tilesMutex);
+    auto cached = this->tiles.find(index);
+    if (cached != this->tiles.end())
+    {
+        this->recentTiles.splice(this->recentTiles.begin(), this->recentTiles, cached->second.second);
+        this->stats.hits++;
+        countEvent(Counter::TileHits);
+        return cached->second.first;
+    }
+
+    // Read under the lock so two threads missing the same tile do not both read it
+    std::shared_ptr<const Tile> tile = readTile(index);
+    this->stats.misses++;
+    countEvent(Counter::TileMisses);
+    prefetchAround(tileRow, tileCol);
+
+    if (this->tiles.size() >= this->maxTiles)
+    {
+        this->tiles.erase(this->recentTiles.back());
+        this->recentTiles.pop_back();
+        this->stats.evictions++;
+        countEvent(Counter::TileEvictions);
+    }
+    this->recentTiles.push_front(index);
+    this->tiles.emplace(index, std::make_pair(tile, this->recentTiles.begin()));
+
+    return tile;
+}
+
+/**
+ * Get the cost of a cell. Searches read many cells of the same tile, which a TileCursor does without going through
+ * the cache for each.
+ *
+ * @param row The row of the cell
+ * @param col The column of the cell
+ * @return float The cost of the cell
+ */
+float TiledGrid::cost(int row, int col)
+{
+    std::shared_ptr<const Tile> tile = getTile(row / this->tileSize, col / this->tileSize);
+    return (*tile)[(size_t)(row % this->tileSize) * this->tileSize + col % this->tileSize];
+}
+
+/**
+ * Get how the tiles requested so far in this process were found and how much the cache holds.
+ *
+ * @return TileCacheStats The counts of the tile cache
+ */
+TileCacheStats TiledGrid::getStats() const
+{
+    std::lock_guard<std::mutex> lock(this->tilesMutex);
+    TileCacheStats stats = this->stats;
+    stats.residentTiles = this->tiles.size();
+    stats.residentBytes = this->tiles.size() * (size_t)this->tileSize * this->tileSize * sizeof(float);
+    return stats;
+}
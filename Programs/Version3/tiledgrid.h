@@ -0,0 +1,185 @@
+#ifndef TILEDGRID_H
+#define TILEDGRID_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gridformat.h"
+#include "metrics.h"
+
+/**
+ * The memory budget of the tile cache of a tiled grid unless one is given, in bytes.
+ */
+const size_t defaultTileCacheBytes = 256ull << 20;
+
+/**
+ * Counts of how the tiles of a tiled grid were found by this process.
+ */
+struct TileCacheStats
+{
+    size_t hits = 0;          // Found in the tile cache
+    size_t misses = 0;        // Read from the file
+    size_t evictions = 0;     // Dropped to stay within the memory budget
+    size_t residentTiles = 0; // Held by the tile cache now
+    size_t residentBytes = 0; // Held by the tile cache now, in bytes
+    size_t budgetBytes = 0;   // The memory budget of the tile cache
+};
+
+/**
+ * A cost grid in the tiled grid format that is read a tile at a time instead of being loaded, so it can be larger than
+ * memory. The tiles read are kept in a cache that drops the least recently used tile once the cache holds more than
+ * its memory budget. Reading a tile asks the kernel to read the tiles around it ahead, since searches move to
+ * neighboring tiles. The cache is shared by the threads of a process and each forked process has its own copy.
+ *
+ * Tiles are handed out as shared pointers, so a tile in use stays valid after it is dropped from the cache.
+ */
+class TiledGrid
+{
+public:
+    // The costs of a tile, row by row
+    using Tile = std::vector<float>;
+
+private:
+    std::string gridPath;
+    int fd = -1;
+    int numRows = 0, numCols = 0;
+    int tileSize = 0;
+    int numTileRows = 0, numTileCols = 0;
+    size_t maxTiles;
+
+    // The cached tiles by index, with their place in the order of use, most recently used first
+    std::list<int> recentTiles;
+    std::unordered_map<int, std::pair<std::shared_ptr<const Tile>, std::list<int>::iterator>> tiles;
+    TileCacheStats stats;
+    mutable std::mutex tilesMutex;
+
+    /**
+     * Reads a tile from the file.
+     *
+     * @param index The index of the tile, row by row across the grid
+     * @return std::shared_ptr<const Tile> The costs of the tile
+     */
+    std::shared_ptr<const Tile> readTile(int index) const;
+
+    /**
+     * Asks the kernel to read the tiles around a tile ahead, unless they are cached.
+     *
+     * @param tileRow The row of the tile
+     * @param tileCol The column of the tile
+     */
+    void prefetchAround(int tileRow, int tileCol) const;
+
+public:
+    /**
+     * Opens a tiled grid file. Only its header is read.
+     *
+     * @param gridPath The path to the tiled grid file
+     * @param budgetBytes The memory budget of the tile cache, which always holds at least one tile
+     */
+    TiledGrid(const std::string &gridPath, size_t budgetBytes = defaultTileCacheBytes);
+
+    ~TiledGrid();
+
+    TiledGrid(const TiledGrid &) = delete;
+    TiledGrid &operator=(const TiledGrid &) = delete;
+
+    /**
+     * Get the number of rows of the grid.
+     *
+     * @return int The number of rows
+     */
+    int getNumRows() const { return this->numRows; }
+
+    /**
+     * Get the number of columns of the grid.
+     *
+     * @return int The number of columns
+     */
+    int getNumCols() const { return this->numCols; }
+
+    /**
+     * Get the width of the square tiles of the grid.
+     *
+     * @return int The number of cells along each side of a tile
+     */
+    int getTileSize() const { return this->tileSize; }
+
+    /**
+     * Get a tile from the cache, reading it from the file on a miss.
+     *
+     * @param tileRow The row of the tile
+     * @param tileCol The column of the tile
+     * @return std::shared_ptr<const Tile> The costs of the tile, row by row
+     */
+    std::shared_ptr<const Tile> getTile(int tileRow, int tileCol);
+
+    /**
+     * Get the cost of a cell. Searches read many cells of the same tile, which a TileCursor does without going through
+     * the cache for each.
+     *
+     * @param row The row of the cell
+     * @param col The column of the cell
+     * @return float The cost of the cell
+     */
+    float cost(int row, int col);
+
+    /**
+     * Get how the tiles requested so far in this process were found and how much the cache holds.
+     *
+     * @return TileCacheStats The counts of the tile cache
+     */
+    TileCacheStats getStats() const;
+};
+
+/**
+ * Reads the cells of a tiled grid for one search, keeping the tile of the last cell read so cells of the same tile are
+ * read without going through the tile cache. A cursor is used by one thread at a time.
+ */
+class TileCursor
+{
+private:
+    TiledGrid &grid;
+    int tileSize;
+    int tileRow = -1, tileCol = -1;
+    std::shared_ptr<const TiledGrid::Tile> tile;
+
+public:
+    /**
+     * Constructs a cursor that holds no tile yet.
+     *
+     * @param grid The tiled grid to read
+     */
+    explicit TileCursor(TiledGrid &grid) : grid(grid), tileSize(grid.getTileSize()) {}
+
+    /**
+     * Get the cost of a cell, moving to its tile first if the cursor holds another.
+     *
+     * @param row The row of the cell
+     * @param col The column of the cell
+     * @return float The cost of the cell
+     */
+    float cost(int row, int col)
+    {
+        int cellTileRow = row / this->tileSize, cellTileCol = col / this->tileSize;
+        if (cellTileRow != this->tileRow || cellTileCol != this->tileCol)
+        {
+            this->tile = this->grid.getTile(cellTileRow, cellTileCol);
+            this->tileRow = cellTileRow;
+            this->tileCol = cellTileCol;
+        }
+        return (*this->tile)[(size_t)(row - cellTileRow * this->tileSize) * this->tileSize + (col - cellTileCol * this->tileSize)];
+    }
+};
+
+#endif // TILEDGRID_H
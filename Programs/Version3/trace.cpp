@@ -0,0 +1,185 @@
+#include "trace.h"
+
+bool tracingEnabled = false;
+
+// Where the merged trace is written and where forked processes leave their spans
+std::string traceOutputPath;
+std::string traceFragmentFolder;
+
+// The process that enabled tracing and merges the trace, and when it did
+pid_t traceOwner = 0;
+std::chrono::steady_clock::time_point traceStartTime;
+
+// The spans and name of this process, guarded by the mutex when several threads record spans
+std::vector<TraceEvent> traceEvents;
+std::string traceProcessName;
+std::mutex traceMutex;
+
+/**
+ * Get the path of the fragment file a forked process writes its spans to. The name includes the pid of the process
+ * that enabled tracing so fragments left by other runs are not merged.
+ *
+ * @param pid The pid of the forked process
+ * @return std::string The path to the fragment file
+ */
+std::string traceFragmentPath(pid_t pid)
+{
+    return traceFragmentFolder + "/trace_" + std::to_string(traceOwner) + "_" + std::to_string(pid) + ".json";
+}
+
+/**
+ * Writes a string as a JSON string literal.
+ *
+ * @param out The stream to write to
+ * @param text The string to write
+ */
+void writeJsonString(std::ostream &out, const std::string &text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+/**
+ * Writes the spans and the name of this process as trace events, one per line, each followed by a comma.
+ *
+ * @param out The stream to write to
+ */
+void writeTraceEvents(std::ostream &out)
+{
+    pid_t pid = getpid();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << pid << ", \"args\": {\"name\": ";
+    writeJsonString(out, traceProcessName);
+    out << "}}," << std::endl;
+
+    for (const TraceEvent &event : traceEvents)
+    {
+        out << "{\"name\": ";
+        writeJsonString(out, event.name);
+        out << ", \"ph\": \"X\", \"ts\": " << event.timestamp << ", \"dur\": " << event.duration << ", \"pid\": " << event.pid
+            << ", \"tid\": " << event.tid << "}," << std::endl;
+    }
+}
+
+/**
+ * Writes the spans of this process when it exits. A forked process writes them to its fragment file, and the process
+ * that enabled tracing merges them with every fragment of its descendants into the trace file. Every descendant has
+ * been waited for by then, so their fragments are complete.
+ */
+void writeTraceAtExit()
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (getpid() != traceOwner)
+    {
+        std::ofstream fragment(traceFragmentPath(getpid()));
+        writeTraceEvents(fragment);
+        return;
+    }
+
+    std::ofstream traceFile(traceOutputPath);
+    if (!traceFile.is_open())
+    {
+        std::cerr << "Unable to open trace file: " << traceOutputPath << std::endl;
+        return;
+    }
+
+    traceFile << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    writeTraceEvents(traceFile);
+
+    std::string fragmentPrefix = "trace_" + std::to_string(traceOwner) + "_";
+    for (const auto &entry : std::filesystem::directory_iterator(traceFragmentFolder))
+    {
+        if (entry.path().filename().string().rfind(fragmentPrefix, 0) == 0)
+        {
+            std::ifstream fragment(entry.path());
+            traceFile << fragment.rdbuf();
+            fragment.close();
+            std::filesystem::remove(entry.path());
+        }
+    }
+
+    // Close the array with an event that needs no trailing comma
+    traceFile << "{\"name\": \"trace_end\", \"ph\": \"i\", \"s\": \"g\", \"ts\": "
+              << std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traceStartTime).count()
+              << ", \"pid\": " << traceOwner << ", \"tid\": " << traceOwner << "}" << std::endl;
+    traceFile << "]}" << std::endl;
+}
+
+/**
+ * Enables tracing for this process and the processes it forks from now on. Each process buffers its spans in memory.
+ * A forked process writes its spans to a fragment file in the fragment folder when it exits. When this process exits,
+ * it merges its own spans and the fragments of its descendants into one Chrome trace JSON file, which can be opened in
+ * chrome://tracing or Perfetto.
+ *
+ * @param outputPath The path to the trace file to write
+ * @param fragmentFolder The folder the forked processes write their spans to
+ */
+void enableTracing(const std::string &outputPath, const std::string &fragmentFolder)
+{
+    if (tracingEnabled)
+    {
+        return;
+    }
+
+    traceOutputPath = outputPath;
+    traceFragmentFolder = fragmentFolder;
+    traceOwner = getpid();
+    traceStartTime = std::chrono::steady_clock::now();
+    traceProcessName = "main";
+    tracingEnabled = true;
+
+    std::atexit(writeTraceAtExit);
+
+    // A forked process starts with no spans of its own, and the lock is held across the fork so the spans of the parent
+    // are not copied mid-update
+    pthread_atfork([]
+                   { traceMutex.lock(); },
+                   []
+                   { traceMutex.unlock(); },
+                   []
+                   {
+                       traceEvents.clear();
+                       traceMutex.unlock();
+                   });
+}
+
+/**
+ * Names this process in the trace, for example after it is forked to work on a path.
+ *
+ * @param name The name to show for the process
+ */
+void setTraceProcessName(const std::string &name)
+{
+    if (tracingEnabled)
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        traceProcessName = name;
+    }
+}
+
+/**
+ * Records a span of the calling thread.
+ *
+ * @param name The name of the span
+ * @param startTime When the span started
+ * @param endTime When the span ended
+ */
+void recordTraceSpan(const std::string &name, std::chrono::steady_clock::time_point startTime, std::chrono::steady_clock::time_point endTime)
+{
+    TraceEvent event = {name,
+                        std::chrono::duration<double, std::micro>(startTime - traceStartTime).count(),
+                        std::chrono::duration<double, std::micro>(endTime - startTime).count(),
+                        getpid(),
+                        static_cast<pid_t>(syscall(SYS_gettid))};
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceEvents.push_back(std::move(event));
+}
@@ -0,0 +1,94 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+/**
+ * A span of time spent by one thread of one process, in the units of the Chrome trace event format.
+ */
+struct TraceEvent
+{
+    std::string name;
+    double timestamp; // Microseconds since tracing was enabled
+    double duration;  // Microseconds
+    pid_t pid;
+    pid_t tid;
+};
+
+/**
+ * Whether spans are being recorded. Checked before anything is formatted or timed.
+ */
+extern bool tracingEnabled;
+
+/**
+ * Enables tracing for this process and the processes it forks from now on. Each process buffers its spans in memory.
+ * A forked process writes its spans to a fragment file in the fragment folder when it exits. When this process exits,
+ * it merges its own spans and the fragments of its descendants into one Chrome trace JSON file, which can be opened in
+ * chrome://tracing or Perfetto.
+ *
+ * @param outputPath The path to the trace file to write
+ * @param fragmentFolder The folder the forked processes write their spans to
+ */
+void enableTracing(const std::string &outputPath, const std::string &fragmentFolder);
+
+/**
+ * Names this process in the trace, for example after it is forked to work on a path.
+ *
+ * @param name The name to show for the process
+ */
+void setTraceProcessName(const std::string &name);
+
+/**
+ * Records a span of the calling thread.
+ *
+ * @param name The name of the span
+ * @param startTime When the span started
+ * @param endTime When the span ended
+ */
+void recordTraceSpan(const std::string &name, std::chrono::steady_clock::time_point startTime, std::chrono::steady_clock::time_point endTime);
+
+/**
+ * Records the scope it lives in as a span of the calling thread if tracing is enabled.
+ */
+class TraceScope
+{
+private:
+    std::string name;
+    std::chrono::steady_clock::time_point startTime;
+    bool active;
+
+public:
+    explicit TraceScope(std::string name) : active(tracingEnabled)
+    {
+        if (this->active)
+        {
+            this->name = std::move(name);
+            this->startTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (this->active)
+        {
+            recordTraceSpan(this->name, this->startTime, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+};
+
+#endif // TRACE_H
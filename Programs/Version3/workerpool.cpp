@@ -0,0 +1,270 @@
+#include "workerpool.h"
+
+/**
+ * Forks the worker processes, which inherit the loaded grid and graph and the subpaths cached so far.
+ *
+ * @param numWorkers The number of worker processes, at least one
+ * @param search The search each worker runs on the subpaths sent to it
+ */
+SubpathWorkerPool::SubpathWorkerPool(size_t numWorkers, SubpathSearch search) : search(std::move(search))
+{
+    if (numWorkers == 0)
+    {
+        throw std::invalid_argument("A worker pool needs at least one worker.");
+    }
+
+    // An anonymous shared mapping stays shared with every process forked after it is created
+    this->regionBytes = sizeof(SharedState) + queueCapacity * (sizeof(Job) + sizeof(Result)) + arenaBytes;
+    this->region = mmap(nullptr, this->regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (this->region == MAP_FAILED)
+    {
+        throw std::runtime_error(std::string("Unable to allocate shared memory for the worker pool: ") + std::strerror(errno));
+    }
+    this->shared = new (this->region) SharedState();
+    this->jobs = reinterpret_cast<Job *>(this->shared + 1);
+    this->results = reinterpret_cast<Result *>(this->jobs + queueCapacity);
+    this->arena = reinterpret_cast<uint8_t *>(this->results + queueCapacity);
+
+    pthread_mutexattr_t mutexAttributes;
+    pthread_mutexattr_init(&mutexAttributes);
+    pthread_mutexattr_setpshared(&mutexAttributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mutexAttributes, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&this->shared->mutex, &mutexAttributes);
+    pthread_mutexattr_destroy(&mutexAttributes);
+
+    // The pool waits with a timeout to notice dead workers, measured on the monotonic clock
+    pthread_condattr_t condAttributes;
+    pthread_condattr_init(&condAttributes);
+    pthread_condattr_setpshared(&condAttributes, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&condAttributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&this->shared->jobsQueued, &condAttributes);
+    pthread_cond_init(&this->shared->resultsReady, &condAttributes);
+    pthread_condattr_destroy(&condAttributes);
+
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            runWorker(i);
+        }
+        else if (pid < 0)
+        {
+            std::cerr << "Error forking worker process." << std::endl;
+            exit(80);
+        }
+        countEvent(Counter::Forks);
+        this->workers.push_back(pid);
+    }
+}
+
+/**
+ * Stops the workers once the queue is empty, waits for them to exit and unmaps the shared memory.
+ */
+SubpathWorkerPool::~SubpathWorkerPool()
+{
+    lock();
+    this->shared->stopping = true;
+    pthread_cond_broadcast(&this->shared->jobsQueued);
+    unlock();
+
+    for (pid_t pid : this->workers)
+    {
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+            ;
+    }
+
+    pthread_cond_destroy(&this->shared->jobsQueued);
+    pthread_cond_destroy(&this->shared->resultsReady);
+    pthread_mutex_destroy(&this->shared->mutex);
+    munmap(this->region, this->regionBytes);
+}
+
+/**
+ * Locks the shared mutex, making it consistent again if a worker died holding it.
+ */
+void SubpathWorkerPool::lock()
+{
+    if (pthread_mutex_lock(&this->shared->mutex) == EOWNERDEAD)
+    {
+        pthread_mutex_consistent(&this->shared->mutex);
+    }
+}
+
+/**
+ * Unlocks the shared mutex.
+ */
+void SubpathWorkerPool::unlock()
+{
+    pthread_mutex_unlock(&this->shared->mutex);
+}
+
+/**
+ * Takes jobs from the queue and searches them until the pool stops. Runs in each worker process.
+ *
+ * @param workerIndex The index of the worker in the pool
+ */
+void SubpathWorkerPool::runWorker(size_t workerIndex)
+{
+    setTraceProcessName("worker " + std::to_string(workerIndex));
+
+    while (true)
+    {
+        lock();
+        while (!this->shared->stopping && this->shared->numQueued == 0)
+        {
+            if (pthread_cond_wait(&this->shared->jobsQueued, &this->shared->mutex) == EOWNERDEAD)
+            {
+                pthread_mutex_consistent(&this->shared->mutex);
+            }
+        }
+        if (this->shared->numQueued == 0)
+        {
+            unlock();
+            break;
+        }
+        Job job = this->jobs[this->shared->head];
+        this->shared->head = (this->shared->head + 1) % queueCapacity;
+        this->shared->numQueued--;
+        unlock();
+
+        Result result = {ResultStatus::Failed, 0, 0, 0};
+        CompactPath path;
+        try
+        {
+            TraceScope jobSpan("subpath " + std::to_string(job.resultIndex));
+            std::tie(result.cost, path) = this->search({job.startRow, job.startCol}, {job.endRow, job.endCol});
+            result.status = ResultStatus::Done;
+            result.numSteps = path.numSteps();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Worker " << workerIndex << " failed to search a subpath: " << e.what() << std::endl;
+        }
+
+        // Claim room in the arena under the lock and copy the steps after releasing it
+        lock();
+        size_t numBytes = path.packed().size();
+        if (result.status == ResultStatus::Done && this->shared->arenaUsed + numBytes > arenaBytes)
+        {
+            result.status = ResultStatus::TooLarge;
+        }
+        else if (result.status == ResultStatus::Done)
+        {
+            result.offset = this->shared->arenaUsed;
+            this->shared->arenaUsed += numBytes;
+        }
+        unlock();
+
+        if (result.status == ResultStatus::Done)
+        {
+            std::memcpy(this->arena + result.offset, path.packed().data(), numBytes);
+        }
+
+        lock();
+        this->results[job.resultIndex] = result;
+        this->shared->numCompleted++;
+        pthread_cond_signal(&this->shared->resultsReady);
+        unlock();
+    }
+
+    // The spans of this process have ended, so they are written when it exits
+    exit(0);
+}
+
+/**
+ * Throws if a worker process has exited while the pool is running.
+ */
+void SubpathWorkerPool::checkWorkers()
+{
+    for (size_t i = 0; i < this->workers.size(); i++)
+    {
+        pid_t pid = this->workers[i];
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) == pid)
+        {
+            // The dead worker is reaped, so it is not waited for again when the pool stops
+            this->workers.erase(this->workers.begin() + i);
+            std::string reason = WIFSIGNALED(status) ? "was killed by signal " + std::to_string(WTERMSIG(status))
+                                                     : "exited with status " + std::to_string(WEXITSTATUS(status));
+            throw std::runtime_error("Worker process " + std::to_string(pid) + " " + reason + " while searching subpaths.");
+        }
+    }
+}
+
+/**
+ * Searches subpaths on the workers and waits for all of them. More subpaths than the queue holds are sent in
+ * rounds. A subpath whose steps do not fit in the shared arena is searched in the calling process instead.
+ *
+ * @param subpaths The starting and ending positions of each subpath
+ * @return std::vector<std::pair<float, CompactPath>> The cost and cells of each subpath, in the order given
+ */
+std::vector<std::pair<float, CompactPath>> SubpathWorkerPool::searchSubpaths(const std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> &subpaths)
+{
+    std::vector<std::pair<float, CompactPath>> found(subpaths.size());
+
+    for (size_t roundStart = 0; roundStart < subpaths.size(); roundStart += queueCapacity)
+    {
+        size_t roundSize = std::min(queueCapacity, subpaths.size() - roundStart);
+
+        // The queue is empty between rounds, so the whole round fits behind its head
+        lock();
+        this->shared->numCompleted = 0;
+        this->shared->arenaUsed = 0;
+        for (size_t i = 0; i < roundSize; i++)
+        {
+            const auto &[startPos, endPos] = subpaths[roundStart + i];
+            this->jobs[(this->shared->head + i) % queueCapacity] = {startPos.first, startPos.second, endPos.first, endPos.second, static_cast<uint32_t>(i)};
+            this->results[i].status = ResultStatus::Pending;
+        }
+        this->shared->numQueued = roundSize;
+        pthread_cond_broadcast(&this->shared->jobsQueued);
+
+        // Wake up now and then to notice a worker that died before finishing its job
+        while (this->shared->numCompleted < roundSize)
+        {
+            timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_nsec += 100000000;
+            if (deadline.tv_nsec >= 1000000000)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+
+            int waited = pthread_cond_timedwait(&this->shared->resultsReady, &this->shared->mutex, &deadline);
+            if (waited == EOWNERDEAD)
+            {
+                pthread_mutex_consistent(&this->shared->mutex);
+            }
+            else if (waited == ETIMEDOUT)
+            {
+                unlock();
+                checkWorkers();
+                lock();
+            }
+        }
+        unlock();
+
+        for (size_t i = 0; i < roundSize; i++)
+        {
+            const auto &[startPos, endPos] = subpaths[roundStart + i];
+            const Result &result = this->results[i];
+            if (result.status == ResultStatus::Failed)
+            {
+                throw std::runtime_error("A worker process failed to search the subpath from {" + std::to_string(startPos.first) + ", " +
+                                         std::to_string(startPos.second) + "} to {" + std::to_string(endPos.first) + ", " +
+                                         std::to_string(endPos.second) + "}.");
+            }
+            if (result.status == ResultStatus::TooLarge)
+            {
+                found[roundStart + i] = this->search(startPos, endPos);
+                continue;
+            }
+            found[roundStart + i] = {result.cost, CompactPath(startPos, result.numSteps, this->arena + result.offset)};
+        }
+    }
+
+    return found;
+}
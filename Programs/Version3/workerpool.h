@@ -0,0 +1,152 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <new>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <stdexcept>
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "compactpath.h"
+#include "metrics.h"
+#include "trace.h"
+
+/**
+ * Finds the lowest cost subpath between two positions, returning its cost and cells.
+ */
+using SubpathSearch = std::function<std::pair<float, CompactPath>(std::pair<int, int>, std::pair<int, int>)>;
+
+/**
+ * A fixed pool of worker processes forked once that search subpaths sent to them through a ring buffer of jobs in
+ * shared memory and return the cost and packed steps of each subpath in shared memory, so every subpath is searched
+ * in a process of its own without forking one per subpath. Each worker keeps what it searched in its own subpath
+ * cache, copied from the process that created the pool when the pool was created.
+ *
+ * The queue is guarded by a robust process-shared mutex, so a worker that dies holding it does not block the others.
+ * The pool stops waiting and throws once a worker dies.
+ */
+class SubpathWorkerPool
+{
+private:
+    // A subpath to search and where its result goes
+    struct Job
+    {
+        int32_t startRow, startCol;
+        int32_t endRow, endCol;
+        uint32_t resultIndex;
+    };
+
+    enum class ResultStatus : int32_t
+    {
+        Pending,
+        Done,
+        TooLarge, // The packed steps did not fit in the arena left, so the caller searches the subpath itself
+        Failed
+    };
+
+    // The cost of a searched subpath and where its packed steps are in the arena
+    struct Result
+    {
+        ResultStatus status;
+        float cost;
+        uint32_t numSteps;
+        uint64_t offset;
+    };
+
+    // The state shared by the pool and its workers, followed by the jobs, the results and the arena
+    struct SharedState
+    {
+        pthread_mutex_t mutex;
+        pthread_cond_t jobsQueued;
+        pthread_cond_t resultsReady;
+        size_t head = 0, numQueued = 0;
+        size_t numCompleted = 0;
+        size_t arenaUsed = 0;
+        bool stopping = false;
+    };
+
+    SubpathSearch search;
+    std::vector<pid_t> workers;
+
+    void *region = nullptr;
+    size_t regionBytes = 0;
+    SharedState *shared = nullptr;
+    Job *jobs = nullptr;
+    Result *results = nullptr;
+    uint8_t *arena = nullptr;
+
+    /**
+     * Locks the shared mutex, making it consistent again if a worker died holding it.
+     */
+    void lock();
+
+    /**
+     * Unlocks the shared mutex.
+     */
+    void unlock();
+
+    /**
+     * Takes jobs from the queue and searches them until the pool stops. Runs in each worker process.
+     *
+     * @param workerIndex The index of the worker in the pool
+     */
+    [[noreturn]] void runWorker(size_t workerIndex);
+
+    /**
+     * Throws if a worker process has exited while the pool is running.
+     */
+    void checkWorkers();
+
+public:
+    // The most jobs in the queue at once, which is also the most results held at once
+    static constexpr size_t queueCapacity = 4096;
+
+    // The room for the packed steps of the results held at once, reserved but only backed by memory once written
+    static constexpr size_t arenaBytes = 64ull << 20;
+
+    /**
+     * Forks the worker processes, which inherit the loaded grid and graph and the subpaths cached so far.
+     *
+     * @param numWorkers The number of worker processes, at least one
+     * @param search The search each worker runs on the subpaths sent to it
+     */
+    SubpathWorkerPool(size_t numWorkers, SubpathSearch search);
+
+    /**
+     * Stops the workers once the queue is empty, waits for them to exit and unmaps the shared memory.
+     */
+    ~SubpathWorkerPool();
+
+    SubpathWorkerPool(const SubpathWorkerPool &) = delete;
+    SubpathWorkerPool &operator=(const SubpathWorkerPool &) = delete;
+
+    /**
+     * Get the number of worker processes of the pool.
+     *
+     * @return size_t The number of workers
+     */
+    size_t size() const { return this->workers.size(); }
+
+    /**
+     * Searches subpaths on the workers and waits for all of them. More subpaths than the queue holds are sent in
+     * rounds. A subpath whose steps do not fit in the shared arena is searched in the calling process instead.
+     *
+     * @param subpaths The starting and ending positions of each subpath
+     * @return std::vector<std::pair<float, CompactPath>> The cost and cells of each subpath, in the order given
+     */
+    std::vector<std::pair<float, CompactPath>> searchSubpaths(const std::vector<std::pair<std::pair<int, int>, std::pair<int, int>>> &subpaths);
+};
+
+#endif // WORKERPOOL_H
@@ -16,3 +16,31 @@ for version in {1..3}; do
         exit 1
     fi
 done
+
+# Compile the client for the Version3 query server
+g++ -Wall -std=c++20 ./Programs/Tools/client.cpp -o "${EXE_PREFIX}_client"
+if [ $? -ne 0 ]; then
+    echo "Build failed for the client"
+    exit 1
+fi
+
+# Compile the subpath cache benchmark, optimized so the timings are meaningful
+g++ -Wall -std=c++20 -O2 ./Programs/Tools/cachebench.cpp ./Programs/Version3/subpathcache.cpp ./Programs/Version3/compactpath.cpp -o "${EXE_PREFIX}_cachebench"
+if [ $? -ne 0 ]; then
+    echo "Build failed for the cache benchmark"
+    exit 1
+fi
+
+# Compile the stage benchmark against the Version3 sources, optimized like the cache benchmark
+g++ -Wall -std=c++20 -O2 ./Programs/Tools/benchmark.cpp $(ls ./Programs/Version3/*.cpp | grep -v main.cpp) -o "${EXE_PREFIX}_benchmark"
+if [ $? -ne 0 ]; then
+    echo "Build failed for the benchmark"
+    exit 1
+fi
+
+# Compile the grid generator, optimized so large grids are written quickly
+g++ -Wall -std=c++20 -O2 ./Programs/Tools/gridgen.cpp -o "${EXE_PREFIX}_gridgen"
+if [ $? -ne 0 ]; then
+    echo "Build failed for the grid generator"
+    exit 1
+fi
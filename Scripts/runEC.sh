@@ -1,8 +1,8 @@
 #!/bin/bash
 
 # Check if the correct number of arguments is provided
-if [ "$#" -ne 8 ]; then
-    echo "Usage: $0 <base_exe_name> <rows> <cols> <num_nodes> <start_node> <end_node> <scrap_folder> <output_folder>"
+if [ "$#" -lt 8 ]; then
+    echo "Usage: $0 <base_exe_name> <rows> <cols> <num_nodes> <start_node> <end_node> <scrap_folder> <output_folder> [generator options]"
     exit 1
 fi
 
@@ -15,6 +15,7 @@ START_NODE=$5
 END_NODE=$6
 SCRAP_FOLDER=$7
 OUTPUT_FOLDER=$8
+shift 8
 
 # Check if rows and columns are non-negative
 if [ "$ROWS" -lt 0 ] || [ "$COLS" -lt 0 ]; then
@@ -34,43 +35,49 @@ if [ "$START_NODE" -lt 0 ] || [ "$START_NODE" -ge "$NUM_NODES" ] || [ "$END_NODE
     exit 4
 fi
 
-# Generate grid file
-GRID_FILE="$OUTPUT_FOLDER/grid.txt"
-echo "Generating grid with ${ROWS} rows and ${COLS} columns..."
+# Build the grid generator if it doesn't exist
+GENERATOR="${BASE_EXE_NAME}_gridgen"
+if [ ! -f "${GENERATOR}" ]; then
+    echo "Building ${GENERATOR}..."
+    ./Scripts/build.sh "${BASE_EXE_NAME}"
+fi
 
-# Write to a text file first the number of columns and rows and then the grid values
-# The grid values are floats generated randomly between 0 and 10 with 5 decimal places
-echo "${COLS} ${ROWS}" > $GRID_FILE
-for i in $(seq 1 $ROWS); do
-    for j in $(seq 1 $COLS); do
-        printf "%.5f " $(echo "scale=5; $RANDOM/32768*10" | bc)
-    done
-    echo
-done >> $GRID_FILE
+# Versions 1 and 2 only read text grids, so a binary or tiled grid is written as grid.bin and searched by Version 3 alone
+BINARY_GRID=0
+for option in "$@"; do
+    case "$option" in
+        --binary|--tiled|--tiled=*) BINARY_GRID=1 ;;
+    esac
+done
 
-# Generate node list file
+# Generate the grid and node list files
+# The grid values are floats between 0 and 10 with 5 decimal places, uniformly random unless other generator options
+# such as --seed=N, --distribution=clustered|walls|gradient, --binary or --tiled are given. The node positions are
+# random, unique and within the grid.
+GRID_FILE="$OUTPUT_FOLDER/grid.txt"
+if [ "$BINARY_GRID" -eq 1 ]; then
+    GRID_FILE="$OUTPUT_FOLDER/grid.bin"
+fi
 NODES_FILE="$OUTPUT_FOLDER/nodes.txt"
-echo "Generating ${NUM_NODES} nodes..."
-
-# Write to a text file first the number of nodes and then the node positions
-# Node positions are generated randomly but unique and must be within the grid
-echo "${NUM_NODES} " > $NODES_FILE
-declare -A used_positions
-for i in $(seq 1 $NUM_NODES); do
-    while : ; do
-        row=$(($RANDOM % $ROWS))
-        col=$(($RANDOM % $COLS))
-        pos="${row}_${col}"
-        if [ -z "${used_positions[$pos]}" ]; then
-            used_positions[$pos]=1
-            echo -n "${row} ${col} "
-            break
-        fi
-    done
-done >> $NODES_FILE
+echo "Generating grid with ${ROWS} rows and ${COLS} columns and ${NUM_NODES} nodes..."
+./"${GENERATOR}" $ROWS $COLS $NUM_NODES $GRID_FILE $NODES_FILE "$@"
+if [ $? -ne 0 ]; then
+    echo "Error: Generating the grid failed."
+    exit 5
+fi
 
 # Perform the search for the lowest-cost path
 echo "Searching for the lowest-cost path between nodes ${START_NODE} and ${END_NODE}..."
-./Scripts/run.sh $BASE_EXE_NAME $GRID_FILE $NODES_FILE $START_NODE $END_NODE $SCRAP_FOLDER $OUTPUT_FOLDER
+if [ "$BINARY_GRID" -eq 1 ]; then
+    EXECUTABLE="${BASE_EXE_NAME}3"
+    if [ ! -f "${EXECUTABLE}" ]; then
+        echo "Building ${EXECUTABLE}..."
+        ./Scripts/build.sh "${BASE_EXE_NAME}"
+    fi
+    echo "Running ${EXECUTABLE}..."
+    ./"${EXECUTABLE}" "${GRID_FILE}" "${NODES_FILE}" "${START_NODE}" "${END_NODE}" "${SCRAP_FOLDER}3" "${OUTPUT_FOLDER}/3.txt"
+else
+    ./Scripts/run.sh $BASE_EXE_NAME $GRID_FILE $NODES_FILE $START_NODE $END_NODE $SCRAP_FOLDER $OUTPUT_FOLDER
+fi
 
 echo "Script execution completed."